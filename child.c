@@ -1,111 +1,757 @@
 #include "child.h"
+#include "event.h"
+#include "group.h"
+#include "launch.h"
+#include "scheduler.h"
+#include "settings.h"
+#include "transfer.h"
 
-#include <csse2310a3.h>
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
-// longest possible status is null-terminated "signalled(XXX)" (15 characters)
-#define MAX_STATUS_BUFFER_SIZE 15
+// number of children the job table has room for before it first grows
+#define INITIAL_CHILD_CAPACITY 16
+
+// most children the job table may have room for, so that neither it nor the
+// process ID table (twice its size) outgrows an int index
+#define MAX_CHILD_CAPACITY (1 << 28)
+
+// number of finished or changed children recorded before each record first
+// grows
+#define INITIAL_FINISHED_CAPACITY 16
+#define INITIAL_CHANGED_CAPACITY 16
+
+// number of microseconds in a second
+#define MICROS_PER_SECOND 1000000
+
+// 2^32 divided by the golden ratio, used to hash process IDs
+#define PID_HASH_MULTIPLIER 2654435769u
 
 /* Stores information about child processes created by the spawn command. */
 extern ChildList* childList;
 
+/*
+ * Returns the slot of the global ChildList's arrays holding the child with
+ * the given job ID, or -1 if no slot holds it.
+ */
+static int child_slot(int jobId) {
+    ChildList* list = childList;
+    int mask = list->tableSize - 1;
+
+    // job IDs are handed out in sequence, so they spread evenly unhashed
+    for (int entry = jobId & mask; list->jobTable[entry] >= 0;
+            entry = (entry + 1) & mask) {
+        if (list->jobIds[list->jobTable[entry]] == jobId) {
+            return list->jobTable[entry];
+        }
+    }
+    return -1;
+}
+
+int get_first_slot_from(int jobId) {
+    int low = 0;
+    int high = childList->numChildren;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (childList->jobIds[middle] < jobId) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
 Child* get_child_by_jobid(int jobId) {
-    Child** children = childList->children;
-    for (int i = 0; children[i]; i++) {
-        if (children[i]->jobId == jobId) {
-            return children[i];
+    int slot = child_slot(jobId);
+    if (slot < 0 || childList->statuses[slot].state == CHILD_EVICTED) {
+        return NULL;
+    }
+    return &childList->children[slot];
+}
+
+int get_next_jobid() {
+    return childList->nextJobId;
+}
+
+pid_t get_child_pid(Child* child) {
+    return childList->processIds[child_slot(child->jobId)];
+}
+
+bool is_child_running(Child* child) {
+    return get_child_status(child).state == CHILD_RUNNING;
+}
+
+bool is_child_queued(Child* child) {
+    return get_child_status(child).state == CHILD_QUEUED;
+}
+
+bool is_child_finished(Child* child) {
+    ChildState state = get_child_status(child).state;
+    return state == CHILD_EXITED || state == CHILD_SIGNALLED;
+}
+
+int get_child_group_id(Child* child) {
+    return childList->groupIds[child_slot(child->jobId)];
+}
+
+ChildStatus get_child_status(Child* child) {
+    return childList->statuses[child_slot(child->jobId)];
+}
+
+const char* get_child_program(Child* child) {
+    return get_name(&childList->programNames,
+            childList->programNameIds[child_slot(child->jobId)]);
+}
+
+ChildTimes get_child_times(Child* child) {
+    return childList->times[child_slot(child->jobId)];
+}
+
+ChildUsage get_child_usage(Child* child) {
+    return childList->usage[child_slot(child->jobId)];
+}
+
+/*
+ * Returns the current wall-clock time, in microseconds since the epoch.
+ */
+static int64_t get_wall_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t) now.tv_sec * MICROS_PER_SECOND + now.tv_nsec / 1000;
+}
+
+/*
+ * Returns the given time, as reported by getrusage(), in microseconds.
+ */
+static int64_t get_micros(struct timeval time) {
+    return (int64_t) time.tv_sec * MICROS_PER_SECOND + time.tv_usec;
+}
+
+/*
+ * Returns the entry of the given ChildList's process ID table at which
+ * probing for the given process ID begins.
+ */
+static int pid_entry(ChildList* list, pid_t processId) {
+    // Fibonacci hashing spreads the mostly-sequential process IDs evenly
+    return ((unsigned int) processId * PID_HASH_MULTIPLIER)
+            & (list->tableSize - 1);
+}
+
+/*
+ * Returns the job ID of the child with the given process ID, or -1 if no
+ * child has the given process ID.
+ */
+static int get_jobid_by_pid(pid_t processId) {
+    int mask = childList->tableSize - 1;
+    for (int entry = pid_entry(childList, processId);
+            childList->pidTable[entry] >= 0; entry = (entry + 1) & mask) {
+        // a reaped child's process ID may since have been reused
+        int jobId = childList->pidTable[entry];
+        int slot = child_slot(jobId);
+        if (childList->processIds[slot] == processId
+                && childList->statuses[slot].state == CHILD_RUNNING) {
+            return jobId;
         }
     }
 
-    return NULL;
+    return -1;
 }
 
 Child* get_child_by_pid(int processId) {
-    Child** children = childList->children;
-    for (int i = 0; children[i]; i++) {
-        if (children[i]->processId == processId) {
-            return children[i];
+    return get_child_by_jobid(get_jobid_by_pid(processId));
+}
+
+/*
+ * Inserts the child in the given slot of the given ChildList into its process
+ * ID table, which must have at least one empty entry.
+ */
+static void insert_pid(ChildList* list, int slot) {
+    int mask = list->tableSize - 1;
+    int entry = pid_entry(list, list->processIds[slot]);
+    while (list->pidTable[entry] >= 0) {
+        entry = (entry + 1) & mask;
+    }
+    list->pidTable[entry] = list->jobIds[slot];
+}
+
+/*
+ * Inserts the given slot of the given ChildList into its job ID table, which
+ * must have at least one empty entry.
+ */
+static void insert_slot(ChildList* list, int slot) {
+    int mask = list->tableSize - 1;
+    int entry = list->jobIds[slot] & mask;
+    while (list->jobTable[entry] >= 0) {
+        entry = (entry + 1) & mask;
+    }
+    list->jobTable[entry] = slot;
+}
+
+/*
+ * Returns a lookup table with the given number of entries, all empty, or
+ * NULL if it cannot be allocated.
+ */
+static int* alloc_table(size_t size) {
+    int* table = malloc(sizeof(int) * size);
+    if (table) {
+        memset(table, -1, sizeof(int) * size);
+    }
+    return table;
+}
+
+/*
+ * Empties the lookup tables of the given ChildList and re-inserts every
+ * slot into the job ID table, and every running child into the process ID
+ * table, leaving out children which have been reaped.
+ */
+static void rebuild_tables(ChildList* list) {
+    memset(list->pidTable, -1, sizeof(int) * list->tableSize);
+    memset(list->jobTable, -1, sizeof(int) * list->tableSize);
+    for (int i = 0; i < list->numChildren; i++) {
+        insert_slot(list, i);
+        if (list->statuses[i].state == CHILD_RUNNING) {
+            insert_pid(list, i);
         }
     }
+}
+
+/*
+ * Grows the lookup tables of the given ChildList until they have at least
+ * twice as many entries as the given number of children, and re-inserts
+ * every child into them. The old tables are kept if larger ones cannot be
+ * allocated.
+ *
+ * Returns true if the tables are large enough; false otherwise.
+ */
+static bool grow_tables(ChildList* list, int numChildren) {
+    size_t size = list->tableSize;
+    if ((size_t) numChildren * 2 <= size) {
+        return true;
+    }
+
+    while ((size_t) numChildren * 2 > size) {
+        size *= 2;
+    }
+    int* pidTable = alloc_table(size);
+    int* jobTable = alloc_table(size);
+    if (!pidTable || !jobTable) {
+        free(pidTable);
+        free(jobTable);
+        return false;
+    }
+    free(list->pidTable);
+    free(list->jobTable);
+    list->pidTable = pidTable;
+    list->jobTable = jobTable;
+    list->tableSize = size;
+    rebuild_tables(list);
+    return true;
+}
+
+/*
+ * Resizes the given array to the given number of bytes, leaving it as it was
+ * if it cannot be resized.
+ *
+ * Returns true if the array was resized; false otherwise.
+ */
+static bool resize_array(void** array, size_t size) {
+    void* resized = realloc(*array, size);
+    if (!resized) {
+        return false;
+    }
+    *array = resized;
+    return true;
+}
 
-    return NULL;
+/*
+ * Resizes each of the given ChildList's arrays to hold the given number of
+ * children. If any array cannot be grown, the list's capacity is left as it
+ * was (arrays already grown are simply larger than they need be).
+ *
+ * Returns true if every array was resized; false otherwise.
+ */
+static bool resize_child_arrays(ChildList* list, int capacity) {
+    if (!resize_array((void**) &list->jobIds, sizeof(int) * capacity)
+            || !resize_array((void**) &list->children,
+            sizeof(Child) * capacity)
+            || !resize_array((void**) &list->processIds,
+            sizeof(pid_t) * capacity)
+            || !resize_array((void**) &list->statuses,
+            sizeof(ChildStatus) * capacity)
+            || !resize_array((void**) &list->times,
+            sizeof(ChildTimes) * capacity)
+            || !resize_array((void**) &list->usage,
+            sizeof(ChildUsage) * capacity)
+            || !resize_array((void**) &list->programNameIds,
+            sizeof(int) * capacity)
+            || !resize_array((void**) &list->groupIds,
+            sizeof(int) * capacity)
+            || !resize_array((void**) &list->queueIds,
+            sizeof(int) * capacity)) {
+        return false;
+    }
+    list->capacity = capacity;
+    return true;
 }
 
 ChildList* init_child_list() {
     ChildList* childList = malloc(sizeof(ChildList));
+    childList->nextJobId = 0;
     childList->numChildren = 0;
-    Child** children = malloc(sizeof(Child*));
-    childList->children = children;
+    childList->numEvicted = 0;
+    childList->numEvictedSlots = 0;
+    childList->numRunning = 0;
+    childList->jobIds = NULL;
+    childList->children = NULL;
+    childList->processIds = NULL;
+    childList->statuses = NULL;
+    childList->times = NULL;
+    childList->usage = NULL;
+    childList->programNameIds = NULL;
+    childList->groupIds = NULL;
+    childList->queueIds = NULL;
+    resize_child_arrays(childList, INITIAL_CHILD_CAPACITY);
+    init_name_table(&childList->programNames);
+    childList->changedJobs = NULL;
+    childList->numChanged = 0;
+    childList->changedCapacity = 0;
+    childList->finished = NULL;
+    childList->finishedStart = 0;
+    childList->finishedEnd = 0;
+    childList->finishedCapacity = 0;
+    childList->tableSize = INITIAL_CHILD_CAPACITY * 2;
+    childList->pidTable = alloc_table(childList->tableSize);
+    childList->jobTable = alloc_table(childList->tableSize);
     return childList;
 }
 
-Child* init_child(pid_t processId, char* programName, int pToC, int cToP) {
-    // create child
-    Child* child = malloc(sizeof(Child));
-    child->processId = processId;
-    child->jobId = childList->numChildren;
-    child->programName = malloc(strlen(programName) + 1);
-    strcpy(child->programName, programName);
-    child->status = malloc(MAX_STATUS_BUFFER_SIZE);
-    strcpy(child->status, "running");
-    child->pToC = pToC;
-    child->cToP = cToP;
-    child->readStream = fdopen(cToP, "r");
-        
-    // add the child to the list
-    childList->children = realloc(childList->children,
-            sizeof(Child) * (++(childList->numChildren)));
-    childList->children[childList->numChildren - 1] = child;
+bool reserve_children(int capacity) {
+    if (capacity <= childList->capacity) {
+        return true;
+    } else if (capacity > MAX_CHILD_CAPACITY) {
+        return false;
+    }
+
+    // doubled in a size_t, so the loop ends even for the largest request
+    size_t newCapacity = childList->capacity;
+    while (newCapacity < (size_t) capacity) {
+        newCapacity *= 2;
+    }
+    if (newCapacity > MAX_CHILD_CAPACITY) {
+        newCapacity = MAX_CHILD_CAPACITY;
+    }
+    return grow_tables(childList, newCapacity)
+            && resize_child_arrays(childList, newCapacity);
+}
+
+/*
+ * Records that the given child has been spawned or has changed status, unless
+ * it already has been since every job was last reported on.
+ */
+static void mark_changed(Child* child) {
+    if (child->changed) {
+        return;
+    }
+
+    ChildList* list = childList;
+    if (list->numChanged == list->changedCapacity) {
+        list->changedCapacity = list->changedCapacity
+                ? list->changedCapacity * 2 : INITIAL_CHANGED_CAPACITY;
+        list->changedJobs = realloc(list->changedJobs,
+                sizeof(int) * list->changedCapacity);
+    }
+    list->changedJobs[list->numChanged++] = child->jobId;
+    child->changed = true;
+}
 
+Child* init_child(pid_t processId, char* programName, int groupId, int pToC,
+        int cToP) {
+    Child* child = init_queued_child(programName, groupId, -1);
+    start_child(child, processId, pToC, cToP);
     return child;
 }
 
+Child* init_queued_child(char* programName, int groupId, int queueId) {
+    int slot = childList->numChildren++;
+    childList->jobIds[slot] = childList->nextJobId++;
+    insert_slot(childList, slot);
+    childList->processIds[slot] = 0;
+    childList->statuses[slot] = (ChildStatus) {CHILD_QUEUED, 0};
+    childList->times[slot] = (ChildTimes) {0, 0, 0, 0};
+    childList->usage[slot] = (ChildUsage) {0, 0, 0, 0, 0, 0};
+    childList->programNameIds[slot] =
+            intern_name(&childList->programNames, programName);
+    childList->groupIds[slot] = groupId;
+    childList->queueIds[slot] = queueId;
+
+    Child* child = &childList->children[slot];
+    child->jobId = childList->jobIds[slot];
+    child->pToC = -1;
+    child->cToP = -1;
+    init_line_buffer(&child->output);
+    child->outputPaused = false;
+    init_ring_buffer(&child->input);
+    child->inputWatched = false;
+    child->closeInput = false;
+    child->transferFd = -1;
+    child->pipeTarget = -1;
+    child->pipeSource = -1;
+    child->changed = false;
+    mark_changed(child);
+    child->bytesSent = 0;
+    child->bytesReceived = 0;
+    child->linesSent = 0;
+    child->linesReceived = 0;
+
+    return child;
+}
+
+void start_child(Child* child, pid_t processId, int pToC, int cToP) {
+    int slot = child_slot(child->jobId);
+    childList->processIds[slot] = processId;
+    childList->statuses[slot] = (ChildStatus) {CHILD_RUNNING, 0};
+    childList->times[slot].startTime = get_wall_time();
+    join_group(childList->groupIds[slot], processId);
+    childList->numRunning++;
+    insert_pid(childList, slot);
+
+    child->pToC = pToC;
+    child->cToP = cToP;
+    fcntl(pToC, F_SETFL, fcntl(pToC, F_GETFL) | O_NONBLOCK);
+    fcntl(cToP, F_SETFL, fcntl(cToP, F_GETFL) | O_NONBLOCK);
+}
+
 void report_single_child(Child* child) {
-    wait_on_child(child);
-    printf("[%d] %s:%s\n", child->jobId, child->programName, child->status);
-    fflush(stdout);
+    int slot = child_slot(child->jobId);
+    ChildStatus status = childList->statuses[slot];
+    printf("[%d] %s:", child->jobId, get_child_program(child));
+    if (status.state == CHILD_EXITED) {
+        printf("exited(%d)\n", status.value);
+    } else if (status.state == CHILD_SIGNALLED) {
+        printf("signalled(%d)\n", status.value);
+    } else if (status.state == CHILD_QUEUED) {
+        printf("queued\n");
+    } else {
+        printf("running\n");
+    }
 }
 
-void wait_on_child(Child* child) {
-    int statusCode;
-    char* status = child->status;
-    
-    // only wait on child and write to its status string if the last status
-    // was running - if it has been changed already, it cannot change again
-    if (!strcmp(status, "running")
-            && waitpid(child->processId, &statusCode, WNOHANG)) {
-        if (WIFEXITED(statusCode)) { // statusCode => exited
-            sprintf(status, "exited(%d)", WEXITSTATUS(statusCode));
-        } else if (WIFSIGNALED(statusCode)) { // statusCode => signalled
-            sprintf(status, "signalled(%d)", WTERMSIG(statusCode));
+void clear_changed_children() {
+    for (int i = 0; i < childList->numChanged; i++) {
+        Child* child = get_child_by_jobid(childList->changedJobs[i]);
+        if (child) {
+            child->changed = false;
+        }
+    }
+    childList->numChanged = 0;
+}
+
+/*
+ * Records that the given child has finished, so it can later be evicted.
+ */
+static void record_finished(Child* child) {
+    ChildList* list = childList;
+    if (list->finishedEnd == list->finishedCapacity) {
+        if (list->finishedStart) { // reuse the space of evicted children
+            memmove(list->finished, list->finished + list->finishedStart,
+                    sizeof(FinishedChild)
+                    * (list->finishedEnd - list->finishedStart));
+            list->finishedEnd -= list->finishedStart;
+            list->finishedStart = 0;
         } else {
-            strcpy(status, "running");
+            list->finishedCapacity = list->finishedCapacity
+                    ? list->finishedCapacity * 2 : INITIAL_FINISHED_CAPACITY;
+            list->finished = realloc(list->finished,
+                    sizeof(FinishedChild) * list->finishedCapacity);
+        }
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    list->finished[list->finishedEnd++] = (FinishedChild) {child->jobId,
+            now.tv_sec};
+}
+
+/*
+ * Closes the given reaped child's input pipe, which nothing will read,
+ * discarding any queued input and cancelling any transfer into it.
+ */
+static void close_reaped_input(Child* child) {
+    if (child->pToC < 0) {
+        return;
+    }
+    cancel_transfer(child);
+    ring_buffer_clear(&child->input);
+    close_input(child);
+}
+
+/*
+ * Records that the given child has changed status, reporting on it if the
+ * watch setting is on.
+ */
+static void announce_change(Child* child) {
+    mark_changed(child);
+    if (settings.watchStatus) {
+        report_single_child(child);
+        if (!settings.batchMode) {
+            fflush(stdout);
+        }
+    }
+}
+
+/*
+ * Records that the given queued child will never be started, giving it the
+ * given status as though it had ended the moment it started.
+ */
+static void end_queued_child(Child* child, ChildStatus status) {
+    int slot = child_slot(child->jobId);
+    childList->statuses[slot] = status;
+    childList->times[slot].startTime = childList->times[slot].endTime =
+            get_wall_time();
+    child->output.eof = true;
+    announce_change(child);
+    record_finished(child);
+}
+
+void cancel_queued_child(Child* child) {
+    end_queued_child(child, (ChildStatus) {CHILD_SIGNALLED, SIGKILL});
+}
+
+void fail_queued_child(Child* child) {
+    end_queued_child(child, (ChildStatus) {CHILD_EXITED, EXIT_EXEC_FAIL});
+}
+
+/*
+ * Records the given wait status and resource usage, as reported by wait4(),
+ * as the status of the child with the given job ID.
+ */
+static void update_child_status(int jobId, int statusCode,
+        struct rusage* usage) {
+    int slot = child_slot(jobId);
+    if (WIFEXITED(statusCode)) { // statusCode => exited
+        childList->statuses[slot] = (ChildStatus) {CHILD_EXITED,
+                WEXITSTATUS(statusCode)};
+    } else if (WIFSIGNALED(statusCode)) { // statusCode => signalled
+        childList->statuses[slot] = (ChildStatus) {CHILD_SIGNALLED,
+                WTERMSIG(statusCode)};
+    } else {
+        return;
+    }
+    childList->numRunning--;
+    leave_group(childList->groupIds[slot]);
+
+    ChildTimes* times = &childList->times[slot];
+    times->endTime = get_wall_time();
+    times->userTime = get_micros(usage->ru_utime);
+    times->systemTime = get_micros(usage->ru_stime);
+    ChildUsage* childUsage = &childList->usage[slot];
+    childUsage->maxResident = usage->ru_maxrss;
+    childUsage->voluntarySwitches = usage->ru_nvcsw;
+    childUsage->involuntarySwitches = usage->ru_nivcsw;
+
+    Child* child = &childList->children[slot];
+    announce_change(child);
+
+    close_reaped_input(child);
+    if (child->cToP < 0) {
+        record_finished(child);
+    }
+
+    if (childList->queueIds[slot] >= 0) {
+        finish_queued_job(childList->queueIds[slot]);
+    }
+}
+
+void reap_children(bool block) {
+    int statusCode;
+    struct rusage usage;
+    while (childList->numRunning) {
+        pid_t processId = wait4(-1, &statusCode, block ? 0 : WNOHANG,
+                &usage);
+        if (processId < 0 && errno == EINTR) {
+            continue;
+        } else if (processId <= 0) { // nothing left to reap (yet)
+            break;
         }
+
+        int jobId = get_jobid_by_pid(processId);
+        if (jobId >= 0) {
+            update_child_status(jobId, statusCode, &usage);
+        }
+    }
+
+    // jobs started within the loop could exit and be reaped in turn, each
+    // starting more before the event loop closes any of their pipes
+    run_queued_jobs();
+}
+
+ssize_t read_child_output(Child* child) {
+    if (child->output.eof) {
+        return 0;
+    }
+
+    ssize_t numRead = fill_line_buffer(&child->output, child->cToP);
+    if (numRead > 0) {
+        child->bytesReceived += numRead;
+        limit_child_output(child);
+    } else if (!numRead) {
+        close_child_output(child);
+    }
+    return numRead;
+}
+
+/*
+ * Returns true if the output buffered for the given child has reached the
+ * maxoutput setting; false otherwise.
+ */
+static bool is_output_full(Child* child) {
+    return settings.maxOutput && child->output.end - child->output.start
+            >= (size_t) settings.maxOutput;
+}
+
+void limit_child_output(Child* child) {
+    if (!child->outputPaused && is_output_full(child)) {
+        child->outputPaused = true;
+        unwatch_child(child);
+    }
+}
+
+void resume_child_output(Child* child) {
+    if (!child->outputPaused || is_output_full(child)) {
+        return;
+    }
+
+    child->outputPaused = false;
+    if (child->cToP >= 0 && child->pipeTarget < 0) {
+        watch_child(child);
+    }
+}
+
+void close_child_output(Child* child) {
+    if (child->cToP < 0) {
+        return;
+    }
+
+    // a finished job usually has nothing left to read, and keeping its
+    // empty buffer would cost a page of memory per job
+    if (child->output.start == child->output.end) {
+        free_line_buffer(&child->output);
+    }
+    child->output.eof = true;
+    unwatch_child(child);
+    close(child->cToP);
+    child->cToP = -1;
+    if (!is_child_running(child)) {
+        record_finished(child);
+    }
+}
+
+/*
+ * Evicts the child with the given job ID, freeing its buffers.
+ */
+static void evict_child(int jobId) {
+    int slot = child_slot(jobId);
+    Child* child = &childList->children[slot];
+    free_line_buffer(&child->output);
+    free_ring_buffer(&child->input);
+    childList->statuses[slot].state = CHILD_EVICTED;
+    childList->numEvicted++;
+    childList->numEvictedSlots++;
+}
+
+/*
+ * Removes every slot holding an evicted child from the given ChildList's
+ * arrays, moving the slots kept down in order so that their job IDs stay
+ * sorted.
+ */
+static void compact_children(ChildList* list) {
+    int numKept = 0;
+    for (int i = 0; i < list->numChildren; i++) {
+        if (list->statuses[i].state == CHILD_EVICTED) {
+            continue;
+        }
+        if (i != numKept) {
+            list->jobIds[numKept] = list->jobIds[i];
+            list->children[numKept] = list->children[i];
+            list->processIds[numKept] = list->processIds[i];
+            list->statuses[numKept] = list->statuses[i];
+            list->times[numKept] = list->times[i];
+            list->usage[numKept] = list->usage[i];
+            list->programNameIds[numKept] = list->programNameIds[i];
+            list->groupIds[numKept] = list->groupIds[i];
+            list->queueIds[numKept] = list->queueIds[i];
+        }
+        numKept++;
     }
+    list->numChildren = numKept;
+    list->numEvictedSlots = 0;
+    rebuild_tables(list);
 }
 
-void reap_child(int signum, siginfo_t* info, void* ucontext) {
-    Child* child = get_child_by_pid(info->si_pid);
-    wait_on_child(child);
+void evict_children() {
+    ChildList* list = childList;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    while (list->finishedStart < list->finishedEnd) {
+        FinishedChild* oldest = &list->finished[list->finishedStart];
+        int numFinished = list->finishedEnd - list->finishedStart;
+        if ((!settings.retainJobs || numFinished <= settings.retainJobs)
+                && (!settings.retainSeconds || now.tv_sec - oldest->finishTime
+                < settings.retainSeconds)) {
+            break;
+        }
+        evict_child(oldest->jobId);
+        list->finishedStart++;
+    }
+
+    // moving the arrays costs as much as the slots kept, so wait until at
+    // least as many slots are freed
+    if (list->numEvictedSlots
+            && list->numEvictedSlots * 2 >= list->numChildren) {
+        compact_children(list);
+    }
 }
 
 void free_child_list() {
-    Child** children = childList->children;
-    for (int i = 0; children[i]; i++) {
-        Child* child = children[i];
-        free(child->programName);
-        free(child->status);
-        fclose(child->readStream);
-        free(child);
-    }
-    free(children);
+    for (int i = 0; i < childList->numChildren; i++) {
+        Child* child = &childList->children[i];
+        free_line_buffer(&child->output);
+        free_ring_buffer(&child->input);
+        if (child->pToC >= 0) {
+            close(child->pToC);
+        }
+        if (child->cToP >= 0) {
+            close(child->cToP);
+        }
+        if (child->transferFd >= 0) {
+            close(child->transferFd);
+        }
+    }
+    free(childList->jobIds);
+    free(childList->children);
+    free(childList->processIds);
+    free(childList->statuses);
+    free(childList->times);
+    free(childList->usage);
+    free(childList->programNameIds);
+    free(childList->groupIds);
+    free(childList->queueIds);
+    free_name_table(&childList->programNames);
+    free(childList->changedJobs);
+    free(childList->finished);
+    free(childList->pidTable);
+    free(childList->jobTable);
     free(childList);
 }
-
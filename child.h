@@ -1,72 +1,350 @@
 #ifndef CHILD_H
 #define CHILD_H
 
+#include "linebuf.h"
+#include "names.h"
+#include "ringbuf.h"
+
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <signal.h>
 #include <sys/types.h>
+#include <time.h>
+
+/* States a child process can be in. */
+typedef enum {
+    CHILD_RUNNING,
+    CHILD_EXITED,
+    CHILD_SIGNALLED,
+    /* Finished and forgotten under the retention settings; the child's
+     * slot is kept only until it is compacted away. */
+    CHILD_EVICTED,
+    /* Submitted with the queue command, but not yet started; there is no
+     * process, and both pipes are -1. */
+    CHILD_QUEUED
+} ChildState;
+
+/* Stores the status of a child process in two bytes. The status is only
+ * formatted as a string when it is reported. */
+typedef struct {
+    /* State of the process; a ChildState. */
+    unsigned char state;
+    /* Exit code of an exited process, or number of the signal which
+     * terminated a signalled process; 0 while running. */
+    unsigned char value;
+} ChildStatus;
+
+/* Stores when a child process ran and the CPU time it used. Times are in
+ * microseconds. */
+typedef struct {
+    /* Wall-clock time at which the process was spawned, since the epoch; 0
+     * while queued. */
+    int64_t startTime;
+    /* Wall-clock time at which the process was reaped, since the epoch; 0
+     * while running. */
+    int64_t endTime;
+    /* CPU time spent in user mode, as reported by wait4(), or as last
+     * sampled while running (0 if never sampled). */
+    int64_t userTime;
+    /* CPU time spent in kernel mode, as reported by wait4(), or as last
+     * sampled while running (0 if never sampled). */
+    int64_t systemTime;
+} ChildTimes;
 
-/* Stores information used to manipulate processes. */
+/* Stores the resources used by a child process, other than CPU time. */
+typedef struct {
+    /* Largest resident set size, in KiB: as reported by wait4(), or the
+     * largest sampled while running. */
+    int64_t maxResident;
+    /* Resident set size, in KiB, when last sampled; 0 if never sampled. */
+    int64_t resident;
+    /* Number of voluntary context switches, as reported by wait4(); 0 while
+     * running. */
+    int64_t voluntarySwitches;
+    /* Number of involuntary context switches, as reported by wait4(); 0
+     * while running. */
+    int64_t involuntarySwitches;
+    /* Number of threads when last sampled; 0 if never sampled. */
+    int numThreads;
+    /* Number of times the process has been sampled. */
+    int numSamples;
+} ChildUsage;
+
+/* Stores the I/O state used to communicate with a child process. The rest of
+ * the child's information is stored in its ChildList's arrays, in the same
+ * slot. */
 typedef struct {
-    /* Process ID of this process, relative to the kernel. */
-    pid_t processId;
     /* Job ID of this process, relative to hq. */
     pid_t jobId;
-    /* Name of the program running within this process. */
-    char* programName;
-    /* Status of this process: running, exited or signalled. */
-    char* status;
-    /* Pipe used to write to this process. */
+    /* Pipe used to write to this process; -1 once closed by the eof command
+     * or because the process was reaped. */
     int pToC;
-    /* Pipe used to query information from this child. */
+    /* Pipe used to query information from this child; -1 once its output
+     * has reached end of file. */
     int cToP;
-    /* Stream used to read from this child. */
-    FILE* readStream;
+    /* Output read from this child but not yet received by the user. */
+    LineBuffer output;
+    /* Whether the event loop has stopped reading this child's output because
+     * its buffer reached the maxoutput setting. */
+    bool outputPaused;
+    /* Input sent to this child but not yet written to its pipe. */
+    RingBuffer input;
+    /* Whether the event loop is watching this child's input pipe. */
+    bool inputWatched;
+    /* Whether this child's input pipe is to be closed once its queued input
+     * and any sendfile or pipe into it have been written. */
+    bool closeInput;
+    /* File being transferred into this child's pipe, or -1 if none. */
+    int transferFd;
+    /* Job ID of the child this child's output is piped into, or -1. */
+    int pipeTarget;
+    /* Job ID of the child whose output is piped into this child, or -1. */
+    int pipeSource;
+    /* Whether this child has been spawned or has changed status since every
+     * job was last reported on. */
+    bool changed;
+    /* Number of bytes written to this child's input pipe. */
+    uint64_t bytesSent;
+    /* Number of bytes read from this child's output pipe, including those
+     * piped into another child. */
+    uint64_t bytesReceived;
+    /* Number of lines sent to this child by the send command. */
+    uint64_t linesSent;
+    /* Number of lines received from this child by the rcv command. */
+    uint64_t linesReceived;
 } Child;
 
-/* Stores multiple Child processes. */
+/* Records when a child finished, so it can be evicted once it is too old. */
+typedef struct {
+    /* Job ID of the finished child. */
+    int jobId;
+    /* Time at which the child finished, from CLOCK_MONOTONIC. */
+    time_t finishTime;
+} FinishedChild;
+
+/* Stores multiple Child processes. Each piece of information about the
+ * children is stored in its own contiguous array, indexed by slot, so that
+ * reporting on and reaping many children reads memory sequentially. Children
+ * occupy slots in order of job ID.
+ *
+ * Job IDs are never reused. When finished children are evicted, their slots
+ * remain until they make up half of the slots in use, and are then all
+ * compacted away at once, wherever they lie. */
 typedef struct {
-    /* Number of Child processes being stored. */
+    /* Job ID the next child added will have. */
+    int nextJobId;
+    /* Number of slots in use, including those of evicted children. */
     int numChildren;
-    /* Array of child processes being stored. */
-    Child** children;
+    /* Number of evicted children, whether or not their slots remain. */
+    int numEvicted;
+    /* Number of slots holding evicted children, yet to be compacted away. */
+    int numEvictedSlots;
+    /* Number of stored Child processes which have not yet been reaped. */
+    int numRunning;
+    /* Number of Child processes each array has room for. */
+    int capacity;
+    /* Job ID of each child, in increasing order. */
+    int* jobIds;
+    /* I/O state of each child. */
+    Child* children;
+    /* Process ID of each child, relative to the kernel; 0 while queued. */
+    pid_t* processIds;
+    /* Status of each child, as last updated by reap_children(). */
+    ChildStatus* statuses;
+    /* Times at which each child ran, and the CPU time it used. */
+    ChildTimes* times;
+    /* Other resources used by each child. */
+    ChildUsage* usage;
+    /* ID, within programNames, of the name of the program each child runs. */
+    int* programNameIds;
+    /* ID of the group each child belongs to. */
+    int* groupIds;
+    /* ID of the queue each child was submitted to, or -1 if it was spawned
+     * directly. */
+    int* queueIds;
+    /* Name of every program run by a child, each stored once. */
+    NameTable programNames;
+    /* Job IDs of children which have changed since every job was last
+     * reported on, in the order they first changed. */
+    int* changedJobs;
+    int numChanged;
+    /* Number of job IDs the changedJobs array has room for. */
+    int changedCapacity;
+    /* Finished children which have not been evicted, oldest first, from
+     * finished[finishedStart] up to finished[finishedEnd]. */
+    FinishedChild* finished;
+    int finishedStart;
+    int finishedEnd;
+    /* Number of FinishedChild records the finished array has room for. */
+    int finishedCapacity;
+    /* Open-addressed (linearly probed) table of the job IDs of running
+     * children, hashed by process ID. Empty entries are -1. */
+    int* pidTable;
+    /* Open-addressed (linearly probed) table of the slot of every child,
+     * evicted or not, keyed by job ID. Empty entries are -1. Rebuilt
+     * whenever slots are compacted away. */
+    int* jobTable;
+    /* Number of entries in pidTable and in jobTable; always a power of two
+     * and at least twice the capacity. */
+    int tableSize;
 } ChildList;
 
 /*
  * Returns a pointer to the child process specified by the given job ID; a NULL
  * pointer is returned if no child has the given job ID.
+ *
+ * Children's slots are looked up by job ID in a hash table, so this takes
+ * expected constant time. Evicted children are treated as though they never
+ * existed. The pointer is only
+ * valid until more room is reserved for children or children are evicted.
  */
 Child* get_child_by_jobid(int jobId);
 
 /*
- * Returns a pointer to the child process specified by the given process ID; a
- * NULL pointer is returned if no child has the given process ID.
+ * Returns the first slot of the global ChildList holding a child (possibly
+ * evicted) whose job ID is at least the given job ID, or the number of slots
+ * in use if there is none.
+ */
+int get_first_slot_from(int jobId);
+
+/*
+ * Returns the job ID the next child added to the global ChildList will have.
+ */
+int get_next_jobid();
+
+/*
+ * Returns a pointer to the running child process specified by the given
+ * process ID; a NULL pointer is returned if no running child has the given
+ * process ID.
+ *
+ * Takes expected constant time and never allocates, so it is safe to use
+ * while reaping children.
  */
 Child* get_child_by_pid(int processId);
 
 /*
- * Returns a pointer to an empty ChildList object with an empty array of
- * children and number of children initialised to 0.
+ * Returns the process ID of the given child.
+ */
+pid_t get_child_pid(Child* child);
+
+/*
+ * Returns true if the given child has been started and has not yet been
+ * reaped; false otherwise.
+ */
+bool is_child_running(Child* child);
+
+/*
+ * Returns true if the given child is waiting in a queue to be started; false
+ * otherwise.
+ */
+bool is_child_queued(Child* child);
+
+/*
+ * Returns true if the given child has exited or been signalled; false
+ * otherwise.
+ */
+bool is_child_finished(Child* child);
+
+/*
+ * Returns the ID of the group the given child belongs to.
+ */
+int get_child_group_id(Child* child);
+
+/*
+ * Returns the status of the given child, as last updated by reap_children().
+ */
+ChildStatus get_child_status(Child* child);
+
+/*
+ * Returns the name of the program the given child runs. The returned string is
+ * only valid until another child is added.
+ */
+const char* get_child_program(Child* child);
+
+/*
+ * Returns the times at which the given child ran and the CPU time it used.
+ */
+ChildTimes get_child_times(Child* child);
+
+/*
+ * Returns the resources, other than CPU time, used by the given child.
+ */
+ChildUsage get_child_usage(Child* child);
+
+/*
+ * Returns a pointer to an empty ChildList object with room for a small number
+ * of children and number of children initialised to 0.
  *
- * The returned ChildList and its array of children are allocated using
- * malloc(). It is the caller's responsibility to free these allocations.
+ * The returned ChildList, its arrays and its process ID table are allocated
+ * using malloc(). It is the caller's responsibility to free these
+ * allocations.
  */
 ChildList* init_child_list();
 
 /*
- * Returns a pointer to a new Child object with the given IDs, program name and
- * communication pipes.
+ * Ensures the global ChildList has room for at least the given number of
+ * children, growing its arrays (and process ID table) geometrically if it
+ * does not. Reserving room up front lets a batch of children be added
+ * without any further reallocation, and keeps the process ID table at most
+ * half full so that probe sequences stay short.
  *
- * The returned Child, its program name, and its status are each allocated by
- * malloc(). It is the caller's responsibility to free these allocations.
+ * Returns true if there is room; false if the table cannot grow that large
+ * or memory cannot be allocated, in which case nothing is added.
  */
-Child* init_child(pid_t processId, char* programName, int pToC, int cToP);
+bool reserve_children(int capacity);
 
 /*
- * Prints a report on the given child process's status. The format of the
+ * Adds a new child with the given IDs, program name and communication pipes
+ * to the global ChildList, and records it as a running member of the group
+ * with the given group ID. Both pipes are made non-blocking. The program name
+ * is copied only if no other child has run a program with the same name.
+ * Room for the child must already have been made with reserve_children().
+ *
+ * Returns a pointer to the new Child, which is stored within the ChildList
+ * and freed by free_child_list().
+ */
+Child* init_child(pid_t processId, char* programName, int groupId, int pToC,
+        int cToP);
+
+/*
+ * Adds a new child, which has not been started, to the global ChildList in
+ * the CHILD_QUEUED state. It will join the group with the given group ID once
+ * started, and was submitted to the queue with the given queue ID.
+ *
+ * Returns a pointer to the new Child, as for init_child().
+ */
+Child* init_queued_child(char* programName, int groupId, int queueId);
+
+/*
+ * Records that the given queued child has been started with the given process
+ * ID and communication pipes, as for init_child(). Never allocates, so it is
+ * safe to use while reaping children.
+ */
+void start_child(Child* child, pid_t processId, int pToC, int cToP);
+
+/*
+ * Records that the given queued child will never be started, as though it had
+ * been killed with SIGKILL the moment it started.
+ */
+void cancel_queued_child(Child* child);
+
+/*
+ * Records that the given queued child could not be started, because its
+ * pipes or process could not be created, as though its program had failed
+ * to execute: it is reported as exited(99).
+ */
+void fail_queued_child(Child* child);
+
+/*
+ * Prints a report on the given child process's status, as last updated by
+ * reap_children(), without flushing standard output. The status is formatted
+ * from its stored state as it is printed. The format of the
  * printed string is:
  *      [Job] cmd:status
  * Where Job is the jobId of the process, cmd is the name of the program the
  * process is executing and status is the status of the process and is either:
+ *      "queued"            ;
  *      "running"           ;
  *      "exited(code)"      , where code is the process's exit code; or
  *      "signalled(signum)" , where signum is the number of the signal which
@@ -75,35 +353,86 @@ Child* init_child(pid_t processId, char* programName, int pToC, int cToP);
 void report_single_child(Child* child);
 
 /*
- * Waits on the given child.
+ * Reaps every child which has terminated, using a single sweep of wait4(-1)
+ * calls rather than one call per child, and updates the status of each
+ * reaped child (found through the process ID table). The time each child is
+ * reaped, and the CPU time, peak memory and context switches reported for it
+ * by wait4(), are recorded.
+ *
+ * A reaped child which has exited has its state changed to CHILD_EXITED, and
+ * its exit code is recorded. A reaped child which was terminated by a signal
+ * has its state changed to CHILD_SIGNALLED, and the number of the signal sent
+ * to the child is recorded.
  *
- * If the child's status has not changed since it was last waited on (or since
- * it was created, if it has not yet been waited on), the child's status is
- * unchanged.
+ * Each reaped child is recorded as changed and, if the watch setting is on,
+ * reported on straight away. Once every terminated child has been reaped,
+ * queued children are started in place of any reaped from a queue.
  *
- * If the child has exited since last it was waited on, the child's status is
- * changed to "exited(X)", where X is the child's exit code and possibly a
- * two-digit number.
+ * A reaped child's input pipe is closed at once: any input still queued for
+ * it is discarded, and any sendfile or pipe into it is cancelled.
  *
- * If the child has been signalled, resulting in termination, since it was last
- * waited on, the child's status is changed to "signalled(X)", where X is the
- * number of the signal sent to the child.
+ * If block is set, this waits until every running child has been reaped;
+ * callers must ensure every running child is about to terminate. Otherwise,
+ * only children which have already terminated are reaped.
  */
-void wait_on_child(Child* child);
+void reap_children(bool block);
 
 /*
- * Signal handler to reap a child which sends a SIGCHLD signal.
+ * Clears the record of changed children, as every job has been reported on.
  */
-void reap_child(int signum, siginfo_t* info, void* ucontext);
+void clear_changed_children();
 
 /*
- * Frees the global ChildList and all of its children.
+ * Performs a single non-blocking read of any output waiting in the given
+ * child's pipe, appending it to the child's output buffer, which is then
+ * limited with limit_child_output(). If the output has reached end of file,
+ * the pipe is closed with close_child_output().
+ *
+ * Returns the number of bytes read, 0 if the child's output has reached end
+ * of file or -1 on error (including when no output is waiting), with errno
+ * set by read().
  */
-void free_child_list();
+ssize_t read_child_output(Child* child);
+
+/*
+ * Stops watching the given child's output pipe if the output buffered for it
+ * has reached the maxoutput setting, so that the child blocks once the pipe
+ * fills rather than its output growing without limit.
+ */
+void limit_child_output(Child* child);
+
+/*
+ * Starts watching the given child's output pipe again if it was stopped by
+ * limit_child_output() and its buffer has since been drained below the
+ * maxoutput setting. A pipe whose output is piped into another job is left
+ * to the pipe.
+ */
+void resume_child_output(Child* child);
+
+/*
+ * Stops watching and closes the given child's output pipe, marking its output
+ * as having reached end of file. Output already read into the child's buffer
+ * remains available; the buffer is freed if it is empty. Does nothing if the
+ * pipe is already closed.
+ */
+void close_child_output(Child* child);
+
+/*
+ * Evicts finished children (those which have been reaped and whose output has
+ * reached end of file) from the global ChildList, oldest first, until no more
+ * than the retain setting remain and none finished more than the retainsecs
+ * setting ago. A setting of 0 places no limit. Evicted children's buffers are
+ * freed, and any output not yet received is discarded.
+ *
+ * Once at least half of the ChildList's slots hold evicted children, those
+ * slots are compacted away, so a long-lived job does not hold on to the slots
+ * of every job evicted after it.
+ */
+void evict_children();
 
 /*
- * Frees the given Child and all of its members.
+ * Frees the global ChildList and all of its children.
  */
-void free_child(Child* child);
+void free_child_list();
 
 #endif
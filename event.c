@@ -0,0 +1,245 @@
+#include "child.h"
+#include "event.h"
+#include "sample.h"
+#include "transfer.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <time.h>
+#include <unistd.h>
+
+// maximum number of events handled per call to epoll_wait()
+#define MAX_EVENTS 64
+
+// number of nanoseconds in a second and in a millisecond
+#define NANOS_PER_SECOND 1000000000LL
+#define NANOS_PER_MILLI 1000000LL
+
+// sources of events, stored in the low bits of each event's data; events from
+// a child's pipes also store the child's job ID in the remaining bits
+#define EVENT_STDIN 0
+#define EVENT_SIGNAL 1
+#define EVENT_CHILD_OUTPUT 2
+#define EVENT_CHILD_INPUT 3
+#define EVENT_SOURCE_BITS 2
+#define EVENT_SOURCE_MASK ((1 << EVENT_SOURCE_BITS) - 1)
+
+/* Event loop shared by all of hq. */
+static EventLoop eventLoop;
+
+/*
+ * Discards every pending SIGCHLD notification from the signalfd and reaps all
+ * terminated children. Notifications coalesce, so they are not matched to
+ * individual children.
+ */
+static void handle_child_signals() {
+    struct signalfd_siginfo info[MAX_EVENTS];
+    while (read(eventLoop.signalFd, info, sizeof(info)) > 0) {
+        // drain the signalfd so it stops reporting readiness
+    }
+    reap_children(false);
+}
+
+void init_event_loop() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+
+    eventLoop.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    eventLoop.signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = EVENT_SIGNAL;
+    epoll_ctl(eventLoop.epollFd, EPOLL_CTL_ADD, eventLoop.signalFd, &event);
+
+    // epoll_ctl() fails with EPERM for regular files, which are always ready
+    event.data.u64 = EVENT_STDIN;
+    eventLoop.stdinPollable = !epoll_ctl(eventLoop.epollFd, EPOLL_CTL_ADD,
+            STDIN_FILENO, &event);
+}
+
+void watch_child(Child* child) {
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = ((uint64_t) child->jobId << EVENT_SOURCE_BITS)
+            | EVENT_CHILD_OUTPUT;
+    epoll_ctl(eventLoop.epollFd, EPOLL_CTL_ADD, child->cToP, &event);
+}
+
+void unwatch_child(Child* child) {
+    epoll_ctl(eventLoop.epollFd, EPOLL_CTL_DEL, child->cToP, NULL);
+}
+
+void watch_child_input(Child* child) {
+    if (child->inputWatched) {
+        return;
+    }
+    child->inputWatched = true;
+
+    struct epoll_event event;
+    event.events = EPOLLOUT;
+    event.data.u64 = ((uint64_t) child->jobId << EVENT_SOURCE_BITS)
+            | EVENT_CHILD_INPUT;
+    epoll_ctl(eventLoop.epollFd, EPOLL_CTL_ADD, child->pToC, &event);
+}
+
+void unwatch_child_input(Child* child) {
+    if (!child->inputWatched) {
+        return;
+    }
+    child->inputWatched = false;
+    epoll_ctl(eventLoop.epollFd, EPOLL_CTL_DEL, child->pToC, NULL);
+}
+
+/*
+ * Drains output which has arrived from the given child into its buffer, or
+ * into the child it is piped into. Once the child's output reaches end of
+ * file, its pipe is closed and no longer watched.
+ */
+static void handle_child_output(Child* child) {
+    if (child->pipeTarget >= 0) {
+        relay_pipe(child);
+        return;
+    }
+
+    ssize_t numRead = read_child_output(child);
+    if (numRead < 0 && errno != EAGAIN && errno != EINTR) {
+        // nothing more will arrive, so stop waking up for the hangup
+        close_child_output(child);
+    }
+}
+
+/*
+ * Handles every pending event, waiting at most timeout milliseconds (or
+ * indefinitely if timeout is negative) for the first to arrive.
+ *
+ * Returns true if standard input was reported ready; false otherwise.
+ */
+static bool handle_events(int timeout) {
+    struct epoll_event events[MAX_EVENTS];
+    bool stdinReady = false;
+
+    // write input queued by commands before sleeping, so that it is batched
+    // but never left waiting
+    flush_queued_input();
+
+    int numEvents = epoll_wait(eventLoop.epollFd, events, MAX_EVENTS,
+            get_sample_timeout(timeout));
+    for (int i = 0; i < numEvents; i++) {
+        uint64_t data = events[i].data.u64;
+        Child* child = get_child_by_jobid(data >> EVENT_SOURCE_BITS);
+        switch (data & EVENT_SOURCE_MASK) {
+            case EVENT_STDIN:
+                stdinReady = true;
+                break;
+            case EVENT_SIGNAL:
+                handle_child_signals();
+                break;
+            case EVENT_CHILD_OUTPUT:
+                handle_child_output(child);
+                break;
+            case EVENT_CHILD_INPUT:
+                continue_transfer(child);
+                break;
+        }
+    }
+    sample_children_if_due();
+
+    return stdinReady;
+}
+
+bool process_events(int timeout) {
+    // regular files are always ready, so there is no point waiting
+    if (!eventLoop.stdinPollable) {
+        handle_events(0);
+        return true;
+    }
+    return handle_events(timeout);
+}
+
+void get_deadline(double seconds, struct timespec* deadline) {
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    long long nanos = deadline->tv_nsec + (long long) (seconds
+            * NANOS_PER_SECOND);
+    deadline->tv_sec += nanos / NANOS_PER_SECOND;
+    deadline->tv_nsec = nanos % NANOS_PER_SECOND;
+}
+
+/*
+ * Returns the number of nanoseconds from now until the given deadline, which
+ * is negative if the deadline has passed.
+ */
+static long long get_nanos_until(const struct timespec* deadline) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) (deadline->tv_sec - now.tv_sec) * NANOS_PER_SECOND
+            + deadline->tv_nsec - now.tv_nsec;
+}
+
+/*
+ * Starts (if watch is set) or stops watching standard input, if it can be
+ * watched at all.
+ */
+static void set_stdin_watched(bool watch) {
+    if (!eventLoop.stdinPollable) {
+        return;
+    } else if (!watch) {
+        epoll_ctl(eventLoop.epollFd, EPOLL_CTL_DEL, STDIN_FILENO, NULL);
+        return;
+    }
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = EVENT_STDIN;
+    epoll_ctl(eventLoop.epollFd, EPOLL_CTL_ADD, STDIN_FILENO, &event);
+}
+
+bool run_events_until(const struct timespec* deadline,
+        EventCondition condition, Child* child) {
+    // commands waiting on standard input would otherwise wake every wait
+    set_stdin_watched(false);
+
+    bool met;
+    while (!(met = condition && condition(child))) {
+        int timeout = -1;
+        if (deadline) {
+            long long remaining = get_nanos_until(deadline);
+            if (remaining <= 0) {
+                break;
+            }
+
+            // epoll_wait() only counts whole milliseconds, so the last
+            // fraction of one is slept precisely instead
+            timeout = remaining / NANOS_PER_MILLI;
+            if (!timeout) {
+                while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                        deadline, NULL) == EINTR) {
+                    // sleep out the remainder
+                }
+                timeout = 0;
+            }
+        }
+        handle_events(timeout);
+    }
+
+    set_stdin_watched(true);
+    return met;
+}
+
+void wait_for_input() {
+    while (!process_events(-1)) {
+        // keep handling child events until a command can be read
+    }
+}
+
+void free_event_loop() {
+    close(eventLoop.signalFd);
+    close(eventLoop.epollFd);
+}
@@ -0,0 +1,97 @@
+#ifndef EVENT_H
+#define EVENT_H
+
+#include "child.h"
+
+#include <stdbool.h>
+#include <time.h>
+
+/* Stores the descriptors used by hq's event loop. */
+typedef struct {
+    /* epoll instance watching standard input, child pipes and signals. */
+    int epollFd;
+    /* signalfd receiving SIGCHLD, which is blocked for normal delivery. */
+    int signalFd;
+    /* Whether standard input can be watched by epoll; regular files cannot,
+     * and are always treated as ready. */
+    bool stdinPollable;
+} EventLoop;
+
+/*
+ * Blocks SIGCHLD and creates the global event loop, watching standard input
+ * and a signalfd for SIGCHLD.
+ */
+void init_event_loop();
+
+/*
+ * Starts watching the given child's output pipe, so that output is drained
+ * into the child's buffer as soon as it arrives.
+ */
+void watch_child(Child* child);
+
+/*
+ * Stops watching the given child's output pipe.
+ */
+void unwatch_child(Child* child);
+
+/*
+ * Starts watching the given child's input pipe for room to write, so that
+ * queued input or a pending transfer to the child continues when the child
+ * catches up. Does nothing if the pipe is already watched.
+ */
+void watch_child_input(Child* child);
+
+/*
+ * Stops watching the given child's input pipe. Does nothing if the pipe is not
+ * watched.
+ */
+void unwatch_child_input(Child* child);
+
+/*
+ * Handles every pending event, waiting at most timeout milliseconds (or
+ * indefinitely if timeout is negative) for the first to arrive. Queued input
+ * is written to children first. Child output is drained into the children's
+ * buffers, pending transfers to children continue and exited children are
+ * reaped. Running children are sampled if a sample is due, and the wait is cut
+ * short if one falls due first.
+ *
+ * Returns true if standard input has input (or end of file) ready to be read;
+ * false otherwise.
+ */
+bool process_events(int timeout);
+
+/*
+ * Handles events until standard input is ready to be read.
+ */
+void wait_for_input();
+
+/* Condition on a child which ends run_events_until(). */
+typedef bool (*EventCondition)(Child* child);
+
+/*
+ * Stores in deadline the time, on the CLOCK_MONOTONIC clock, the given number
+ * of seconds from now.
+ */
+void get_deadline(double seconds, struct timespec* deadline);
+
+/*
+ * Handles events, other than standard input becoming ready, until the given
+ * condition holds for the given child or the given deadline (from
+ * get_deadline()) passes. A NULL condition never holds, and a NULL deadline
+ * never passes.
+ *
+ * Events are waited for with whole-millisecond timeouts, and the last
+ * fraction of a millisecond is slept with clock_nanosleep(), so the deadline
+ * is met precisely.
+ *
+ * Returns true if the condition held; false if the deadline passed first.
+ */
+bool run_events_until(const struct timespec* deadline,
+        EventCondition condition, Child* child);
+
+/*
+ * Closes the descriptors used by the global event loop.
+ */
+void free_event_loop();
+
+#endif
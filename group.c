@@ -0,0 +1,89 @@
+#include "group.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+// number of groups the group list has room for before it first grows
+#define INITIAL_GROUP_CAPACITY 4
+
+/* Stores every named group of jobs. */
+static GroupList groupList;
+
+int get_group_id(char* name, bool create) {
+    for (int i = 0; i < groupList.numGroups; i++) {
+        if (!strcmp(groupList.groups[i].name, name)) {
+            return i;
+        }
+    }
+
+    if (!create) {
+        return -1;
+    }
+
+    if (groupList.numGroups == groupList.capacity) {
+        groupList.capacity = groupList.capacity ? groupList.capacity * 2
+                : INITIAL_GROUP_CAPACITY;
+        groupList.groups = realloc(groupList.groups,
+                sizeof(JobGroup) * groupList.capacity);
+    }
+
+    JobGroup* group = &groupList.groups[groupList.numGroups];
+    group->name = strdup(name);
+    group->processGroupId = 0;
+    group->numRunning = 0;
+    return groupList.numGroups++;
+}
+
+JobGroup* get_group(int groupId) {
+    return &groupList.groups[groupId];
+}
+
+int get_num_groups() {
+    return groupList.numGroups;
+}
+
+pid_t get_process_group(int groupId) {
+    JobGroup* group = get_group(groupId);
+    if (group->processGroupId && kill(-group->processGroupId, 0)
+            && errno == ESRCH) {
+        group->processGroupId = 0;
+    }
+    return group->processGroupId;
+}
+
+void join_group(int groupId, pid_t processId) {
+    JobGroup* group = get_group(groupId);
+    group->numRunning++;
+    pid_t processGroupId = getpgid(processId);
+    if (processGroupId > 0) {
+        group->processGroupId = processGroupId;
+    } else if (!group->processGroupId) {
+        group->processGroupId = processId;
+    }
+}
+
+void leave_group(int groupId) {
+    JobGroup* group = get_group(groupId);
+    if (!--group->numRunning) {
+        group->processGroupId = 0;
+    }
+}
+
+void signal_group(int groupId, int signum) {
+    JobGroup* group = get_group(groupId);
+    if (group->numRunning) {
+        kill(-group->processGroupId, signum);
+    }
+}
+
+void free_groups() {
+    for (int i = 0; i < groupList.numGroups; i++) {
+        free(groupList.groups[i].name);
+    }
+    free(groupList.groups);
+}
@@ -0,0 +1,85 @@
+#ifndef GROUP_H
+#define GROUP_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+/* Name of the group joined by jobs spawned without a group name. */
+#define DEFAULT_GROUP_NAME "default"
+
+/* Stores information about a named process group of jobs. */
+typedef struct {
+    /* Name of this group, as given to the spawn command. */
+    char* name;
+    /* Process group ID shared by this group's jobs; 0 if the group has no
+     * process group, because no member has been spawned yet, all of its
+     * members have been reaped or (as found by get_process_group()) every
+     * member still running has left it. */
+    pid_t processGroupId;
+    /* Number of this group's jobs which have not yet been reaped. */
+    int numRunning;
+} JobGroup;
+
+/* Stores every named group of jobs. */
+typedef struct {
+    /* Number of groups being stored. */
+    int numGroups;
+    /* Number of groups the groups array has room for. */
+    int capacity;
+    /* Array of groups being stored, indexed by group ID. */
+    JobGroup* groups;
+} GroupList;
+
+/*
+ * Returns the ID of the group with the given name, creating the group if
+ * create is set and it does not exist yet. Returns -1 if there is no such
+ * group and create is not set.
+ */
+int get_group_id(char* name, bool create);
+
+/*
+ * Returns a pointer to the group with the given group ID. The pointer is only
+ * valid until a group is next created.
+ */
+JobGroup* get_group(int groupId);
+
+/*
+ * Returns the number of groups which have been created.
+ */
+int get_num_groups();
+
+/*
+ * Returns the ID of the process group the next job in the group with the
+ * given ID should join, or 0 if it should lead a new process group. A
+ * process group whose leader has been reaped and whose other members have
+ * all left it (with setsid, say) no longer exists and cannot be joined, so
+ * it is forgotten.
+ */
+pid_t get_process_group(int groupId);
+
+/*
+ * Records that a job in the group with the given ID has been spawned with
+ * the given process ID. The process group the job actually joined becomes
+ * the group's process group, so a job which had to lead a new process group
+ * in place of one which no longer exists takes over the group.
+ */
+void join_group(int groupId, pid_t processId);
+
+/*
+ * Records that a job in the group with the given ID has been reaped. Once all
+ * of the group's jobs have been reaped, its process group no longer exists.
+ */
+void leave_group(int groupId);
+
+/*
+ * Sends the given signal to every running job in the group with the given
+ * ID with a single kill() call on the group's process group.
+ */
+void signal_group(int groupId, int signum);
+
+/*
+ * Frees every group.
+ */
+void free_groups();
+
+#endif
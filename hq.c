@@ -1,52 +1,272 @@
 #include "child.h"
+#include "event.h"
+#include "group.h"
 #include "hq.h"
+#include "launch.h"
+#include "linebuf.h"
+#include "linescan.h"
+#include "pool.h"
+#include "report.h"
+#include "sample.h"
+#include "scheduler.h"
+#include "settings.h"
+#include "tokens.h"
+#include "transfer.h"
 
-#include <csse2310a3.h>
 #include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
 #define EOF_MIN_EXP_ARGS 2
+#define FLUSH_MIN_EXP_ARGS 2
 #define RCV_MIN_EXP_ARGS 2
 #define SEND_MIN_EXP_ARGS 3
+#define SENDFILE_MIN_EXP_ARGS 3
+#define SET_MIN_EXP_ARGS 3
+#define PIPE_MIN_EXP_ARGS 3
+#define POOL_MIN_EXP_ARGS 4
 #define SIGNAL_MIN_EXP_ARGS 3
+#define QUEUE_MIN_EXP_ARGS 2
 #define SLEEP_MIN_EXP_ARGS 2
 #define SPAWN_MIN_EXP_ARGS 2
+#define WAIT_MIN_EXP_ARGS 2
 
-#define EXIT_EXEC_FAIL 99
- 
-#define PIPE_WRITE_END 1
-#define PIPE_READ_END 0
+#define SPAWN_COUNT_FLAG "-n"
+
+// most jobs a single spawn, queue or pool command may create
+#define MAX_JOB_COUNT 1000000
+#define SPAWN_GROUP_FLAG "--group"
+
+// options to the spawn command which limit or place the new jobs
+#define SPAWN_CPU_FLAG "--cpu"
+#define SPAWN_NICE_FLAG "--nice"
+#define SPAWN_RLIMIT_AS_FLAG "--rlimit-as"
+#define SPAWN_RLIMIT_CPU_FLAG "--rlimit-cpu"
+#define SPAWN_CGROUP_FLAG "--cgroup"
+
+// options to the queue command, other than -n and --group
+#define QUEUE_PRIORITY_FLAG "--priority"
+#define QUEUE_NAME_FLAG "--queue"
+#define QUEUE_LIMIT_FLAG "--limit"
+
+// value of the --cpu option which pins each new job to the next CPU in turn
+#define SPAWN_CPU_ROUND_ROBIN "rr"
+
+// range of niceness accepted by the --nice option
+#define MIN_NICENESS -20
+#define MAX_NICENESS 19
+
+// option to the report command which adds a readout of descriptor usage
+#define REPORT_FDS_FLAG "--fds"
+
+// option to the report command which only reports on jobs which have changed
+#define REPORT_CHANGED_FLAG "--changed"
+
+// option to the report command which adds each job's resource usage
+#define REPORT_STATS_FLAG "--stats"
+
+// option to the report command which chooses the report's format, followed
+// immediately by the format's name
+#define REPORT_FORMAT_FLAG "--format="
+
+// directory listing this process's open descriptors
+#define FD_DIRECTORY "/proc/self/fd"
+
+// target of the signal command which covers every job
+#define SIGNAL_ALL_JOBS "all"
+
+// command line options
+#define BATCH_FLAG "--batch"
+#define SCRIPT_FLAG "-f"
+
+// exit status when the command line or script is invalid
+#define EXIT_BAD_USAGE 1
+
+// size of the standard output buffer in batch mode
+#define BATCH_OUTPUT_BUFFER_SIZE (1 << 20)
+
+// number of script commands run between checks for child events
+#define SCRIPT_EVENT_INTERVAL 64
+
+// key of a command with the given name length and first character, as
+// switched on by find_command()
+#define COMMAND_KEY(length, first) (((length) << 8) | (first))
+
+// argument to rcv which receives every available line
+#define RCV_ALL_LINES "all"
+
+// most reads rcv makes from a job, so a job producing output faster than it
+// can be printed cannot keep rcv running forever
+#define RCV_MAX_READS 64
+
+// bytes queued for a job before send writes them without waiting
+#define DEFAULT_HIGH_WATER_MARK 65536
+
+// bytes of a job's output buffered before hq stops reading from the job
+#define DEFAULT_MAX_OUTPUT (4 * 1024 * 1024)
 
 /* Stores child processes created by the spawn command. */
 ChildList* childList;
 
-int main() {
+/* Stores settings given on the command line or changed by the set
+ * command. */
+Settings settings;
+
+/* Stores the tokens of the command being run, reused for every command. */
+static TokenList commandTokens;
+
+int main(int argc, char** argv) {
+    settings.highWaterMark = DEFAULT_HIGH_WATER_MARK;
+    settings.maxOutput = DEFAULT_MAX_OUTPUT;
+    settings.maxConcurrency = sysconf(_SC_NPROCESSORS_ONLN);
+    char* scriptPath = NULL;
+    if (!parse_command_line(argc, argv, &scriptPath)) {
+        fprintf(stderr, "Usage: hq [--batch] [-f <script>]\n");
+        return EXIT_BAD_USAGE;
+    }
+
+    // in batch mode, output is only written when the buffer fills
+    if (settings.batchMode) {
+        setvbuf(stdout, NULL, _IOFBF, BATCH_OUTPUT_BUFFER_SIZE);
+    }
+
     set_handlers();
     childList = init_child_list();
+    init_event_loop();
 
-    char* input;
-    printf("> ");
+    int status = EXIT_SUCCESS;
+    if (scriptPath) {
+        if (!run_script(scriptPath)) {
+            fprintf(stderr, "Error: Unable to read script\n");
+            status = EXIT_BAD_USAGE;
+        }
+    } else {
+        run_commands();
+    }
+
+    cleanup();
+    free_child_list();
+    free_groups();
+    free_queues();
+    free_pools();
+    free_event_loop();
+    free_token_list(&commandTokens);
+    free_report_buffer();
+    free_sampler();
     fflush(stdout);
-    input = read_line(stdin);
-    while (input) { // haven't received EOF
-        parse(input);
-        free(input);
+
+    return status;
+}
+
+bool parse_command_line(int argc, char** argv, char** scriptPath) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], BATCH_FLAG)) {
+            settings.batchMode = true;
+        } else if (!strcmp(argv[i], SCRIPT_FLAG) && i + 1 < argc) {
+            settings.batchMode = true;
+            *scriptPath = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void run_commands() {
+    LineBuffer input;
+    init_line_buffer(&input);
+    prompt();
+    while (!input.eof) { // haven't received EOF
+        wait_for_input();
+        if (fill_line_buffer(&input, STDIN_FILENO) < 0 && errno != EINTR) {
+            input.eof = true;
+        }
+
+        // input queued by these commands is written in a batch before the
+        // event loop next waits
+        char* command;
+        while ((command = next_line(&input))) {
+            parse(command);
+            prompt();
+        }
+    }
+    free_line_buffer(&input);
+}
+
+bool run_script(char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info)) {
+        close(fd);
+        return false;
+    } else if (!info.st_size) { // nothing to run, and nothing to map
+        close(fd);
+        return true;
+    }
+
+    // a private mapping lets commands be split up in place, without copying
+    // the script or writing to the file
+    char* script = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (script == MAP_FAILED) {
+        return false;
+    }
+    madvise(script, info.st_size, MADV_SEQUENTIAL);
+
+    char* end = script + info.st_size;
+    int numCommands = 0;
+    for (char* command = script; command < end; numCommands++) {
+        char* newline = find_newline(command, end - command);
+        if (newline) {
+            *newline = '\0';
+            parse(command);
+            command = newline + 1;
+        } else { // the last line has no room for a terminator, so copy it
+            char* lastCommand = strndup(command, end - command);
+            parse(lastCommand);
+            free(lastCommand);
+            command = end;
+        }
+
+        // keep jobs' pipes moving without polling after every command
+        if (!(numCommands % SCRIPT_EVENT_INTERVAL)) {
+            process_events(0);
+        }
+    }
+
+    munmap(script, info.st_size);
+    return true;
+}
+
+void prompt() {
+    if (!settings.batchMode) {
         printf("> ");
         fflush(stdout);
-        input = read_line(stdin);
     }
+}
 
-    cleanup();
-    free_child_list();
-     
-    return EXIT_SUCCESS;
+void flush_output() {
+    if (!settings.batchMode) {
+        fflush(stdout);
+    }
 }
 
 void set_handlers() {
@@ -56,220 +276,951 @@ void set_handlers() {
     ignore.sa_flags = SA_RESTART;
     sigaction(SIGINT, &ignore, NULL);
     sigaction(SIGPIPE, &ignore, NULL);
-
-    struct sigaction reapChild;
-    memset(&reapChild, 0, sizeof(struct sigaction));
-    reapChild.sa_sigaction = reap_child;
-    reapChild.sa_flags = SA_RESTART | SA_SIGINFO;
-    sigaction(SIGCHLD, &reapChild, NULL);
 }
 
 void parse(char* command) {
-    int numArgs;
-    char** args = split_space_not_quote(command, &numArgs);
-
+    int numArgs = split_tokens(&commandTokens, command);
     if (!numArgs) { // if command is either empty or whitespace-only
         return;
     }
-    
-    char* program = args[0];
-
-    if (!strcmp(program, "spawn")) {
-        spawn(numArgs, args);
-    } else if (!strcmp(program, "report")) {
-        report(numArgs, args);
-    } else if (!strcmp(program, "signal")) {
-        send_signal(numArgs, args);
-    } else if (!strcmp(program, "sleep")) {
-        sleep_hq(numArgs, args);
-    } else if (!strcmp(program, "send")) {
-        send(numArgs, args);
-    } else if (!strcmp(program, "rcv")) {
-        rcv(numArgs, args);
-    } else if (!strcmp(program, "eof")) {
-        eof(numArgs, args);
-    } else if (!strcmp(program, "cleanup")) {
-        cleanup();
+
+    // finished jobs are only forgotten between commands, so no command sees
+    // a job disappear part way through
+    evict_children();
+
+    char** args = commandTokens.tokens;
+    Command run = find_command(args[0]);
+    if (run) {
+        run(numArgs, args);
     } else {
         printf("Error: Invalid command\n");
+        flush_output();
+    }
+}
+
+Command find_command(char* name) {
+    // each command has a unique length and first character (bar sleep and
+    // spawn, and pipe and pool, each pair told apart by their second), so at
+    // most one full comparison is made per command
+    char* expected;
+    Command command;
+    switch (COMMAND_KEY(strlen(name), name[0])) {
+        case COMMAND_KEY(3, 'e'):
+            expected = "eof";
+            command = eof;
+            break;
+        case COMMAND_KEY(3, 'r'):
+            expected = "rcv";
+            command = rcv;
+            break;
+        case COMMAND_KEY(3, 's'):
+            expected = "set";
+            command = set;
+            break;
+        case COMMAND_KEY(4, 'p'):
+            expected = (name[1] == 'i') ? "pipe" : "pool";
+            command = (name[1] == 'i') ? pipe_jobs : pool;
+            break;
+        case COMMAND_KEY(4, 's'):
+            expected = "send";
+            command = send;
+            break;
+        case COMMAND_KEY(4, 'w'):
+            expected = "wait";
+            command = wait_job;
+            break;
+        case COMMAND_KEY(5, 'f'):
+            expected = "flush";
+            command = flush;
+            break;
+        case COMMAND_KEY(5, 'q'):
+            expected = "queue";
+            command = queue;
+            break;
+        case COMMAND_KEY(5, 's'):
+            expected = (name[1] == 'l') ? "sleep" : "spawn";
+            command = (name[1] == 'l') ? sleep_hq : spawn;
+            break;
+        case COMMAND_KEY(6, 'r'):
+            expected = "report";
+            command = report;
+            break;
+        case COMMAND_KEY(6, 's'):
+            expected = "signal";
+            command = send_signal;
+            break;
+        case COMMAND_KEY(7, 'c'):
+            expected = "cleanup";
+            command = cleanup_hq;
+            break;
+        case COMMAND_KEY(8, 's'):
+            expected = "sendfile";
+            command = send_file;
+            break;
+        case COMMAND_KEY(10, 'w'):
+            expected = "waitoutput";
+            command = wait_output;
+            break;
+        default:
+            return NULL;
     }
 
-    free(args);
+    return strcmp(name, expected) ? NULL : command;
+}
+
+/*
+ * Starts the given number of jobs running the program named by
+ * programArgs[0], with the arguments programArgs, in the group with the given
+ * ID. Each job is given the given limits, pinned to the next CPU in turn if
+ * roundRobin is set. Stops at the first job which cannot be created, after
+ * printing an error message.
+ *
+ * Returns the number of jobs started.
+ */
+static int launch_jobs(char** programArgs, int groupId, LaunchLimits* limits,
+        bool roundRobin, int count) {
+    // size the job table once for the whole batch
+    if (!reserve_children(childList->numChildren + count)) {
+        printf("Error: Unable to create job\n");
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        int pToC;
+        int cToP;
+        if (roundRobin) {
+            next_round_robin_cpu(&limits->cpus);
+        }
+        pid_t childId = launch_program(programArgs,
+                get_process_group(groupId), limits, &pToC, &cToP);
+        if (childId < 0) {
+            printf("Error: Unable to create job\n");
+            return i;
+        }
+
+        Child* child = init_child(childId, programArgs[0], groupId, pToC,
+                cToP);
+        watch_child(child);
+    }
+    return count;
+}
+
+/*
+ * Prints the job IDs of the jobs added since the job with the given job ID,
+ * which have had the given action applied to them.
+ */
+static void report_new_jobs(int firstJobId, const char* action) {
+    int lastJobId = get_next_jobid() - 1;
+    if (lastJobId == firstJobId) {
+        printf("New Job ID [%d] %s\n", firstJobId, action);
+    } else if (lastJobId > firstJobId) {
+        printf("New Job IDs [%d-%d] %s\n", firstJobId, lastJobId, action);
+    }
+    flush_output();
 }
 
 void spawn(int numArgs, char** args) {
-    if (!validate_spawn_args(numArgs, args)) {
+    SpawnOptions options;
+    if (!validate_spawn_args(numArgs, args, &options)) {
         return;
     }
 
-    int pToC[2];
-    pipe(pToC); // parent to child
+    char** programArgs = &args[options.programIndex];
+    if (options.cgroupPath) {
+        options.limits.cgroupFd = open_cgroup(options.cgroupPath);
+        if (options.limits.cgroupFd < 0) {
+            printf("Error: Invalid cgroup\n");
+            flush_output();
+            return;
+        }
+    }
+    int groupId = get_group_id(options.groupName, true);
+    int firstJobId = get_next_jobid();
+    launch_jobs(programArgs, groupId, &options.limits, options.roundRobin,
+            options.count);
 
-    int cToP[2];
-    pipe(cToP); // child to parent
+    if (options.limits.cgroupFd >= 0) {
+        close(options.limits.cgroupFd);
+    }
+    report_new_jobs(firstJobId, "created");
+}
 
-    pid_t childId = fork();
-    if (childId) { // parent
-        // close child's ends of pipes
-        close(pToC[PIPE_READ_END]);
-        close(cToP[PIPE_WRITE_END]);
+/*
+ * Returns true if the given argument is an option to the spawn command; false
+ * otherwise.
+ */
+static bool is_spawn_option(char* arg) {
+    return !strcmp(arg, SPAWN_COUNT_FLAG) || !strcmp(arg, SPAWN_GROUP_FLAG)
+            || !strcmp(arg, SPAWN_CPU_FLAG) || !strcmp(arg, SPAWN_NICE_FLAG)
+            || !strcmp(arg, SPAWN_RLIMIT_AS_FLAG)
+            || !strcmp(arg, SPAWN_RLIMIT_CPU_FLAG)
+            || !strcmp(arg, SPAWN_CGROUP_FLAG);
+}
 
-        Child* child = init_child(childId, args[1], pToC[PIPE_WRITE_END],
-                cToP[PIPE_READ_END]);
-        
-        printf("New Job ID [%d] created\n", child->jobId);
-        fflush(stdout);
-    } else { // child
-        // close parent's ends of pipes
-        close(pToC[PIPE_WRITE_END]);
-        close(cToP[PIPE_READ_END]);
+/*
+ * Parses the value of the given option to the spawn command, other than -n
+ * or --group, into options.
+ *
+ * Returns true if the value is valid; false otherwise, after printing an
+ * error message.
+ */
+static bool validate_spawn_limit(char* option, char* value,
+        SpawnOptions* options) {
+    LaunchLimits* limits = &options->limits;
+    bool valid = true;
+    if (!strcmp(option, SPAWN_CPU_FLAG)) {
+        options->roundRobin = !strcmp(value, SPAWN_CPU_ROUND_ROBIN);
+        valid = options->roundRobin || parse_cpu_list(value, &limits->cpus);
+        limits->pinned = true;
+    } else if (!strcmp(option, SPAWN_NICE_FLAG)) {
+        bool negative = value[0] == '-';
+        valid = validate_int_arg(value + negative, &limits->niceness)
+                && limits->niceness <= (negative ? -MIN_NICENESS
+                : MAX_NICENESS);
+        limits->niceness *= negative ? -1 : 1;
+        limits->niced = true;
+    } else if (!strcmp(option, SPAWN_RLIMIT_AS_FLAG)) {
+        valid = validate_int_arg(value, &limits->addressSpaceMiB)
+                && limits->addressSpaceMiB > 0;
+    } else if (!strcmp(option, SPAWN_RLIMIT_CPU_FLAG)) {
+        valid = validate_int_arg(value, &limits->cpuSeconds)
+                && limits->cpuSeconds > 0;
+    } else {
+        options->cgroupPath = value;
+    }
+
+    if (!valid) {
+        printf("Error: Invalid %s\n", option + 2); // without the dashes
+        flush_output();
+    }
+    return valid;
+}
 
-        // allocate standout I/O files to pipes with parent
-        dup2(pToC[PIPE_READ_END], STDIN_FILENO);
-        dup2(cToP[PIPE_WRITE_END], STDOUT_FILENO);
-        
-        execvp(args[1], &args[1]); // args[0] == "spawn", so skip it
+bool validate_spawn_args(int numArgs, char** args, SpawnOptions* options) {
+    options->count = 1;
+    options->groupName = DEFAULT_GROUP_NAME;
+    init_launch_limits(&options->limits);
+    options->roundRobin = false;
+    options->cgroupPath = NULL;
 
-        // this point is only reached if the above exec() call failed
-        exit(EXIT_EXEC_FAIL);
+    // options come before the program; each takes one value
+    int i = 1;
+    while (i < numArgs && is_spawn_option(args[i])) {
+        if (!validate_num_args(i + 2, numArgs)) {
+            return false;
+        } else if (!strcmp(args[i], SPAWN_COUNT_FLAG)) {
+            if (!validate_int_arg(args[i + 1], &options->count)
+                    || options->count < 1 || options->count > MAX_JOB_COUNT) {
+                printf("Error: Invalid count\n");
+                flush_output();
+                return false;
+            }
+        } else if (!strcmp(args[i], SPAWN_GROUP_FLAG)) {
+            if (!validate_group_name(args[i + 1])) {
+                return false;
+            }
+            options->groupName = args[i + 1];
+        } else if (!validate_spawn_limit(args[i], args[i + 1], options)) {
+            return false;
+        }
+        i += 2;
     }
+
+    options->programIndex = i;
+    return validate_num_args(i + 1, numArgs);
 }
 
-bool validate_spawn_args(int numArgs, char** args) {
-    return validate_num_args(SPAWN_MIN_EXP_ARGS, numArgs);
+void pool(int numArgs, char** args) {
+    int size;
+    if (!validate_pool_args(numArgs, args, &size)) {
+        return;
+    }
+
+    // workers share a group named after the pool, so they can be signalled
+    // together
+    int groupId = get_group_id(args[1], true);
+    int firstJobId = get_next_jobid();
+    int numWorkers = launch_jobs(&args[3], groupId, NULL, false, size);
+    if (numWorkers) {
+        add_pool(args[1], firstJobId, numWorkers);
+    }
+    report_new_jobs(firstJobId, "created");
+}
+
+bool validate_pool_args(int numArgs, char** args, int* size) {
+    if (!validate_num_args(POOL_MIN_EXP_ARGS, numArgs)
+            || !validate_group_name(args[1])) {
+        return false;
+    } else if (get_pool_id(args[1]) >= 0) {
+        printf("Error: Pool exists\n");
+        flush_output();
+        return false;
+    } else if (!validate_int_arg(args[2], size) || *size < 1
+            || *size > MAX_JOB_COUNT) {
+        printf("Error: Invalid pool size\n");
+        flush_output();
+        return false;
+    }
+
+    return true;
+}
+
+void queue(int numArgs, char** args) {
+    QueueOptions options;
+    if (!validate_queue_args(numArgs, args, &options)) {
+        return;
+    }
+
+    char** programArgs = &args[options.programIndex];
+    int queueId = get_queue_id(options.queueName, true);
+    if (options.limit >= 0) {
+        get_queue(queueId)->limit = options.limit;
+    }
+    int groupId = get_group_id(options.groupName, true);
+
+    int firstJobId = get_next_jobid();
+    if (!reserve_children(childList->numChildren + options.count)) {
+        printf("Error: Unable to create job\n");
+        flush_output();
+        return;
+    }
+    for (int i = 0; i < options.count; i++) {
+        Child* child = init_queued_child(programArgs[0], groupId, queueId);
+        enqueue_job(queueId, options.priority, child, programArgs);
+    }
+    run_queued_jobs();
+    report_new_jobs(firstJobId, "queued");
+}
+
+bool validate_queue_args(int numArgs, char** args, QueueOptions* options) {
+    options->count = 1;
+    options->priority = 0;
+    options->queueName = DEFAULT_QUEUE_NAME;
+    options->limit = -1;
+    options->groupName = DEFAULT_GROUP_NAME;
+
+    // options come before the program; each takes one value
+    int i = 1;
+    while (i < numArgs && (!strcmp(args[i], SPAWN_COUNT_FLAG)
+            || !strcmp(args[i], SPAWN_GROUP_FLAG)
+            || !strcmp(args[i], QUEUE_PRIORITY_FLAG)
+            || !strcmp(args[i], QUEUE_NAME_FLAG)
+            || !strcmp(args[i], QUEUE_LIMIT_FLAG))) {
+        if (!validate_num_args(i + 2, numArgs)) {
+            return false;
+        }
+
+        char* value = args[i + 1];
+        if (!strcmp(args[i], SPAWN_COUNT_FLAG)) {
+            if (!validate_int_arg(value, &options->count)
+                    || options->count < 1 || options->count > MAX_JOB_COUNT) {
+                printf("Error: Invalid count\n");
+                flush_output();
+                return false;
+            }
+        } else if (!strcmp(args[i], SPAWN_GROUP_FLAG)) {
+            if (!validate_group_name(value)) {
+                return false;
+            }
+            options->groupName = value;
+        } else if (!strcmp(args[i], QUEUE_PRIORITY_FLAG)) {
+            if (!validate_int_arg(value, &options->priority)) {
+                printf("Error: Invalid priority\n");
+                flush_output();
+                return false;
+            }
+        } else if (!strcmp(args[i], QUEUE_LIMIT_FLAG)) {
+            if (!validate_int_arg(value, &options->limit)) {
+                printf("Error: Invalid limit\n");
+                flush_output();
+                return false;
+            }
+        } else {
+            options->queueName = value;
+        }
+        i += 2;
+    }
+
+    options->programIndex = i;
+    return validate_num_args(i + 1, numArgs);
 }
 
 void report(int numArgs, char** args) {
-    if (!validate_report_args(numArgs, args)) {
+    ReportOptions options;
+    if (!validate_report_args(numArgs, args, &options)) {
         return;
     }
-    Child** children = childList->children;
-    printf("[Job] cmd:status\n");
-    if (numArgs > 1) {
-        Child* child = get_child_by_jobid(atoi(args[1]));
-        report_single_child(child);
+    reap_children(false);
+    start_report(options.format, options.showStats);
+    if (options.changedOnly) {
+        for (int i = 0; i < childList->numChanged; i++) {
+            Child* child = get_child_by_jobid(childList->changedJobs[i]);
+            if (child) { // not evicted
+                add_to_report(child);
+            }
+        }
+        clear_changed_children();
+    } else if (options.child) {
+        add_to_report(options.child);
     } else {
-        for (int i = 0; children[i]; i++) {
-            report_single_child(children[i]);
+        for (int i = 0; i < childList->numChildren; i++) {
+            if (childList->statuses[i].state != CHILD_EVICTED) {
+                add_to_report(&childList->children[i]);
+            }
+        }
+        clear_changed_children();
+    }
+    finish_report();
+    if (options.showDescriptors) {
+        report_descriptors();
+    }
+    flush_output();
+}
+
+bool validate_report_args(int numArgs, char** args, ReportOptions* options) {
+    options->child = NULL;
+    options->showDescriptors = false;
+    options->changedOnly = false;
+    options->format = REPORT_TEXT;
+    options->showStats = false;
+
+    // options come before the job ID, in any order
+    int i = 1;
+    for (; i < numArgs; i++) {
+        if (!strcmp(args[i], REPORT_FDS_FLAG)) {
+            options->showDescriptors = true;
+        } else if (!strcmp(args[i], REPORT_CHANGED_FLAG)) {
+            options->changedOnly = true;
+        } else if (!strcmp(args[i], REPORT_STATS_FLAG)) {
+            options->showStats = true;
+        } else if (!strncmp(args[i], REPORT_FORMAT_FLAG,
+                strlen(REPORT_FORMAT_FLAG))) {
+            if (!validate_report_format(args[i] + strlen(REPORT_FORMAT_FLAG),
+                    &options->format)) {
+                return false;
+            }
+        } else {
+            break;
         }
     }
+    return (numArgs == i || options->changedOnly
+            || validate_jobid(args[i], &options->child));
+}
+
+bool validate_report_format(char* name, ReportFormat* format) {
+    if (!strcmp(name, "text")) {
+        *format = REPORT_TEXT;
+    } else if (!strcmp(name, "json")) {
+        *format = REPORT_JSON;
+    } else if (!strcmp(name, "binary")) {
+        *format = REPORT_BINARY;
+    } else {
+        printf("Error: Invalid format\n");
+        flush_output();
+        return false;
+    }
+    return true;
 }
 
-bool validate_report_args(int numArgs, char** args) {
-    return (numArgs == 1 || validate_jobid(args[1]));
+void report_descriptors() {
+    // every entry but "." and ".." is an open descriptor, one of which is
+    // used to read the directory itself
+    int numOpen = -1;
+    DIR* fds = opendir(FD_DIRECTORY);
+    if (fds) {
+        struct dirent* entry;
+        while ((entry = readdir(fds))) {
+            numOpen += (entry->d_name[0] != '.');
+        }
+        closedir(fds);
+    }
+
+    struct rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    printf("Descriptors: %d open, limit %lld\n", numOpen,
+            (long long) limit.rlim_cur);
+    printf("Jobs: %d retained, %d evicted, %d queued\n",
+            get_next_jobid() - childList->numEvicted, childList->numEvicted,
+            get_num_queued());
 }
 
 void send_signal(int numArgs, char** args) {
-    if (!validate_signal_args(numArgs, args)) {
+    int firstJobId;
+    int lastJobId;
+    int groupId;
+    int signum;
+    if (!validate_signal_args(numArgs, args, &firstJobId, &lastJobId,
+            &groupId, &signum)) {
         return;
     }
 
-    Child* child = get_child_by_jobid(atoi(args[1]));
-    int signum = atoi(args[2]);
+    if (!strcmp(args[1], SIGNAL_ALL_JOBS)) {
+        // one kill() per process group rather than one per job
+        for (int i = 0; i < get_num_groups(); i++) {
+            signal_group(i, signum);
+        }
+    } else if (groupId >= 0) {
+        signal_group(groupId, signum);
+    } else {
+        for (int i = get_first_slot_from(firstJobId); i < childList->numChildren
+                && childList->jobIds[i] <= lastJobId; i++) {
+            // reaped process IDs may have been reused, so leave them alone
+            if (childList->statuses[i].state == CHILD_RUNNING) {
+                kill(childList->processIds[i], signum);
+            }
+        }
+    }
+}
 
-    kill(child->processId, signum);
+/*
+ * Returns true if a child which has not been evicted has a job ID from first
+ * to last (inclusive); false otherwise.
+ */
+static bool has_child_between(int first, int last) {
+    for (int i = get_first_slot_from(first); i < childList->numChildren
+            && childList->jobIds[i] <= last; i++) {
+        if (childList->statuses[i].state != CHILD_EVICTED) {
+            return true;
+        }
+    }
+    return false;
 }
 
-bool validate_signal_args(int numArgs, char** args) {
-    return (
-            validate_num_args(SIGNAL_MIN_EXP_ARGS, numArgs)
-            && validate_jobid(args[1])
-            && validate_signum(args[2])
-            );
+bool validate_signal_args(int numArgs, char** args, int* firstJobId,
+        int* lastJobId, int* groupId, int* signum) {
+    if (!validate_num_args(SIGNAL_MIN_EXP_ARGS, numArgs)) {
+        return false;
+    }
+
+    *groupId = -1;
+    char* target = args[1];
+    char* rangeEnd = strchr(target, '-');
+    if (isdigit(target[0]) && rangeEnd) { // <first>-<last>
+        *rangeEnd = '\0';
+        bool valid = validate_int_arg(target, firstJobId)
+                && validate_int_arg(rangeEnd + 1, lastJobId)
+                && *firstJobId <= *lastJobId;
+        *rangeEnd = '-';
+        // either end may have been evicted, so the range need only hold a
+        // job which has not
+        if (!valid || !has_child_between(*firstJobId, *lastJobId)) {
+            printf("Error: Invalid job\n");
+            flush_output();
+            return false;
+        }
+    } else if (isdigit(target[0])) {
+        Child* child;
+        if (!validate_jobid(target, &child)) {
+            return false;
+        }
+        *firstJobId = *lastJobId = child->jobId;
+    } else if (strcmp(target, SIGNAL_ALL_JOBS)) {
+        *groupId = get_group_id(target, false);
+        if (*groupId < 0) {
+            printf("Error: Invalid job\n");
+            flush_output();
+            return false;
+        }
+    }
+
+    return validate_signum(args[2], signum);
 }
 
 void sleep_hq(int numArgs, char** args) {
-    if (!validate_sleep_args(numArgs, args)) {
+    double seconds;
+    if (!validate_sleep_args(numArgs, args, &seconds)) {
         return;
     }
 
-    sleep(strtod(args[1], NULL));
+    // child events are handled while sleeping, so jobs keep moving (and
+    // queued input is written) until the precise end of the sleep
+    struct timespec deadline;
+    get_deadline(seconds, &deadline);
+    run_events_until(&deadline, NULL, NULL);
 }
 
-bool validate_sleep_args(int numArgs, char** args) {
+bool validate_sleep_args(int numArgs, char** args, double* seconds) {
     if (!validate_num_args(SLEEP_MIN_EXP_ARGS, numArgs)) {
         return false;
     } else if (!validate_numerical_arg(args[1], 1)
-            || (strtod(args[1], NULL) < 0)) {
+            || ((*seconds = strtod(args[1], NULL)) < 0)) {
         printf("Error: Invalid sleep time\n");
-        fflush(stdout);
+        flush_output();
         return false;
     }
 
     return true;
 }
 
+void wait_job(int numArgs, char** args) {
+    Child* child;
+    double timeout;
+    if (!validate_wait_args(numArgs, args, &child, &timeout)) {
+        return;
+    }
+    wait_for_child(child, timeout, has_exited);
+}
+
+void wait_output(int numArgs, char** args) {
+    Child* child;
+    double timeout;
+    if (!validate_wait_args(numArgs, args, &child, &timeout)) {
+        return;
+    }
+    wait_for_child(child, timeout, has_output);
+}
+
+bool validate_wait_args(int numArgs, char** args, Child** child,
+        double* timeout) {
+    if (!validate_num_args(WAIT_MIN_EXP_ARGS, numArgs)
+            || !validate_jobid(args[1], child)) {
+        return false;
+    }
+
+    *timeout = -1;
+    if (numArgs > 2 && (!validate_numerical_arg(args[2], 1)
+            || (*timeout = strtod(args[2], NULL)) < 0)) {
+        printf("Error: Invalid timeout\n");
+        flush_output();
+        return false;
+    }
+
+    return true;
+}
+
+void wait_for_child(Child* child, double timeout, EventCondition condition) {
+    struct timespec deadline;
+    if (timeout >= 0) {
+        get_deadline(timeout, &deadline);
+    }
+    if (!run_events_until(timeout >= 0 ? &deadline : NULL, condition,
+            child)) {
+        printf("<timeout>\n");
+        flush_output();
+    }
+}
+
+bool has_exited(Child* child) {
+    return is_child_finished(child);
+}
+
+bool has_output(Child* child) {
+    return has_line(&child->output) || child->output.eof
+            || child->outputPaused;
+}
+
 void send(int numArgs, char** args) {
-    if (!validate_send_args(numArgs, args)) {
+    Child* child;
+    if (!validate_send_args(numArgs, args, &child)) {
         return;
     }
-    
-    int jobId = atoi(args[1]);
-    Child* child = get_child_by_jobid(jobId);
-    write(child->pToC, args[2], strlen(args[2]));
-    write(child->pToC, "\n", 2);
+
+    if (child->pToC < 0 || child->closeInput) { // input closed with eof
+        return;
+    }
+    queue_input(child, args[2], strlen(args[2]));
+    queue_input(child, "\n", 1);
+    child->linesSent++;
+}
+
+bool validate_send_args(int numArgs, char** args, Child** child) {
+    if (!validate_num_args(SEND_MIN_EXP_ARGS, numArgs)) {
+        return false;
+    } else if (!strncmp(args[1], POOL_PREFIX, strlen(POOL_PREFIX))) {
+        int poolId;
+        if (!validate_pool(args[1] + strlen(POOL_PREFIX), &poolId)) {
+            return false;
+        } else if (!(*child = choose_pool_worker(poolId))) {
+            printf("Error: No worker available\n");
+            flush_output();
+            return false;
+        }
+        return true;
+    } else if (!validate_jobid(args[1], child)
+            || !validate_started(*child)) {
+        return false;
+    } else if (is_transferring(*child)) {
+        printf("Error: Transfer in progress\n");
+        flush_output();
+        return false;
+    }
+
+    return true;
 }
 
-bool validate_send_args(int numArgs, char** args) {
-    return (
-            validate_num_args(SEND_MIN_EXP_ARGS, numArgs)
-            && validate_jobid(args[1])
+void flush(int numArgs, char** args) {
+    Child* child;
+    if (!validate_flush_args(numArgs, args, &child)) {
+        return;
+    }
+
+    if (child->pToC >= 0) {
+        continue_transfer(child);
+    }
+}
+
+bool validate_flush_args(int numArgs, char** args, Child** child) {
+    return (validate_num_args(FLUSH_MIN_EXP_ARGS, numArgs)
+            && validate_jobid(args[1], child)
             );
 }
 
-void rcv(int numArgs, char** args) {
-    if (!validate_rcv_args(numArgs, args)) {
+void send_file(int numArgs, char** args) {
+    Child* child;
+    if (!validate_send_file_args(numArgs, args, &child)) {
         return;
     }
 
-    int jobId = atoi(args[1]);
-    Child* child = get_child_by_jobid(jobId);
+    if (child->pToC < 0 || child->closeInput) { // input closed with eof
+        return;
+    }
 
-    if (!is_ready(child->cToP)) {
-        printf("<no input>\n");
-        fflush(stdout);
+    int fd = open(args[2], O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        printf("Error: Unable to open file\n");
+        flush_output();
         return;
     }
+    start_transfer(child, fd);
+}
 
-    char* input = read_line(child->readStream);
-    if (input) {
-        printf("%s\n", input);
-        free(input);
+bool validate_send_file_args(int numArgs, char** args, Child** child) {
+    if (!validate_num_args(SENDFILE_MIN_EXP_ARGS, numArgs)
+            || !validate_jobid(args[1], child)
+            || !validate_started(*child)) {
+        return false;
+    } else if (is_transferring(*child)) {
+        printf("Error: Transfer in progress\n");
+        flush_output();
+        return false;
+    }
+
+    return true;
+}
+
+void pipe_jobs(int numArgs, char** args) {
+    Child* source;
+    Child* target;
+    if (!validate_pipe_args(numArgs, args, &source, &target)) {
+        return;
+    }
+
+    if (target->pToC < 0 || target->closeInput) { // input closed with eof
+        return;
+    }
+    connect_pipe(source, target);
+}
+
+bool validate_pipe_args(int numArgs, char** args, Child** source,
+        Child** target) {
+    if (!validate_num_args(PIPE_MIN_EXP_ARGS, numArgs)
+            || !validate_jobid(args[1], source)
+            || !validate_jobid(args[2], target)
+            || !validate_started(*source) || !validate_started(*target)) {
+        return false;
+    } else if (*source == *target || (*source)->cToP < 0) {
+        // a source whose output has ended would never close the target's
+        // input
+        printf("Error: Invalid job\n");
+        flush_output();
+        return false;
+    } else if ((*source)->pipeTarget >= 0 || is_transferring(*target)) {
+        printf("Error: Transfer in progress\n");
+        flush_output();
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Prints up to maxLines lines of the given child's output.
+ *
+ * Returns the number of lines printed.
+ */
+static int receive_lines(Child* child, int maxLines) {
+    // lines are split in place in the job's buffer, and anything which
+    // arrived since the event loop last ran is read in large chunks, unless
+    // the output is going straight to another job
+    int numLines = 0;
+    int numReads = 0;
+    while (numLines < maxLines) {
+        char* line = next_line(&child->output);
+        if (line) {
+            printf("%s\n", line);
+            numLines++;
+            child->linesReceived++;
+        } else if (child->pipeTarget >= 0 || numReads++ == RCV_MAX_READS
+                || read_child_output(child) <= 0) {
+            break;
+        }
+    }
+    resume_child_output(child);
+    return numLines;
+}
+
+/*
+ * Prints up to maxLines lines of output from the workers of the pool with the
+ * given ID, taking each worker in turn, starting from where the last rcv from
+ * the pool left off. Sets ended if every worker's output has ended.
+ *
+ * Returns the number of lines printed.
+ */
+static int receive_from_pool(int poolId, int maxLines, bool* ended) {
+    WorkerPool* pool = get_pool(poolId);
+    int numLines = 0;
+    *ended = true;
+    for (int i = 0; i < pool->numWorkers && numLines < maxLines; i++) {
+        Child* worker = get_pool_worker(poolId, pool->nextReceive);
+        pool->nextReceive = (pool->nextReceive + 1) % pool->numWorkers;
+        if (worker) { // evicted workers' output has ended
+            numLines += receive_lines(worker, maxLines - numLines);
+            *ended = *ended && worker->output.eof;
+        }
+    }
+    return numLines;
+}
+
+void rcv(int numArgs, char** args) {
+    Child* child;
+    int poolId;
+    int maxLines;
+    if (!validate_rcv_args(numArgs, args, &child, &poolId, &maxLines)) {
+        return;
+    }
+
+    int numLines;
+    bool ended;
+    if (child) {
+        numLines = receive_lines(child, maxLines);
+        ended = child->output.eof;
     } else {
+        numLines = receive_from_pool(poolId, maxLines, &ended);
+    }
+
+    if (numLines < maxLines && ended) {
         printf("<EOF>\n");
+    } else if (!numLines) {
+        printf("<no input>\n");
     }
 
-    fflush(stdout);
+    flush_output();
 }
 
-bool validate_rcv_args(int numArgs, char** args) {
-    return (validate_num_args(RCV_MIN_EXP_ARGS, numArgs)
-            && validate_jobid(args[1])
-            );
+bool validate_rcv_args(int numArgs, char** args, Child** child, int* poolId,
+        int* maxLines) {
+    *child = NULL;
+    if (!validate_num_args(RCV_MIN_EXP_ARGS, numArgs)) {
+        return false;
+    } else if (!strncmp(args[1], POOL_PREFIX, strlen(POOL_PREFIX))) {
+        if (!validate_pool(args[1] + strlen(POOL_PREFIX), poolId)) {
+            return false;
+        }
+    } else if (!validate_jobid(args[1], child)) {
+        return false;
+    }
+
+    *maxLines = 1;
+    if (numArgs > 2 && !strcmp(args[2], RCV_ALL_LINES)) {
+        *maxLines = INT_MAX;
+    } else if (numArgs > 2
+            && (!validate_int_arg(args[2], maxLines) || *maxLines < 1)) {
+        printf("Error: Invalid line count\n");
+        flush_output();
+        return false;
+    }
+
+    return true;
 }
 
 void eof(int numArgs, char** args) {
-    if (!validate_eof_args(numArgs, args)) {
+    Child* child;
+    if (!validate_eof_args(numArgs, args, &child)) {
+        return;
+    }
+
+    if (child->pToC < 0 || child->closeInput) { // already closed
         return;
     }
 
-    int jobId = atoi(args[1]);
-    Child* child = get_child_by_jobid(jobId);
-    close(child->pToC);
+    // input sent earlier, including any sendfile or pipe still in progress,
+    // is delivered before the pipe is closed
+    child->closeInput = true;
+    continue_transfer(child);
 }
 
-bool validate_eof_args(int numArgs, char** args) {
+bool validate_eof_args(int numArgs, char** args, Child** child) {
     return (validate_num_args(EOF_MIN_EXP_ARGS, numArgs)
-            && validate_jobid(args[1])
+            && validate_jobid(args[1], child)
+            && validate_started(*child)
             );
 }
 
 void cleanup() {
-    Child** children = childList->children;
-    for (int i = 0; children[i]; i++) {
-        kill(children[i]->processId, SIGKILL);
-        wait_on_child(children[i]);
+    // queued jobs would otherwise start as the running jobs are reaped
+    cancel_queued_jobs();
+    reap_children(false);
+    for (int i = 0; i < childList->numChildren; i++) {
+        // reaped process IDs may have been reused, so leave them alone
+        if (childList->statuses[i].state == CHILD_RUNNING) {
+            kill(childList->processIds[i], SIGKILL);
+        }
+    }
+    reap_children(true);
+}
+
+void cleanup_hq(int numArgs, char** args) {
+    cleanup();
+}
+
+void set(int numArgs, char** args) {
+    int* setting;
+    int value;
+    if (!validate_set_args(numArgs, args, &setting, &value)) {
+        return;
     }
+
+    *setting = value;
+
+    // a raised concurrency limit may let queued jobs start
+    run_queued_jobs();
+}
+
+bool validate_set_args(int numArgs, char** args, int** setting,
+        int* value) {
+    if (!validate_num_args(SET_MIN_EXP_ARGS, numArgs)) {
+        return false;
+    } else if (!(*setting = get_setting(args[1]))) {
+        printf("Error: Invalid setting\n");
+        flush_output();
+        return false;
+    } else if (!validate_int_arg(args[2], value)) {
+        printf("Error: Invalid value\n");
+        flush_output();
+        return false;
+    }
+
+    return true;
+}
+
+int* get_setting(char* name) {
+    if (!strcmp(name, "pipesize")) {
+        return &settings.pipeSize;
+    } else if (!strcmp(name, "hwm")) {
+        return &settings.highWaterMark;
+    } else if (!strcmp(name, "maxoutput")) {
+        return &settings.maxOutput;
+    } else if (!strcmp(name, "retain")) {
+        return &settings.retainJobs;
+    } else if (!strcmp(name, "retainsecs")) {
+        return &settings.retainSeconds;
+    } else if (!strcmp(name, "watch")) {
+        return &settings.watchStatus;
+    } else if (!strcmp(name, "samplems")) {
+        return &settings.sampleInterval;
+    } else if (!strcmp(name, "concurrency")) {
+        return &settings.maxConcurrency;
+    }
+    return NULL;
 }
 
 bool validate_num_args(int minExpected, int given) {
@@ -277,7 +1228,7 @@ bool validate_num_args(int minExpected, int given) {
         return true;
     }
     printf("Error: Insufficient arguments\n");
-    fflush(stdout);
+    flush_output();
     return false;
 }
 
@@ -299,23 +1250,69 @@ bool validate_numerical_arg(char* arg, int allowFractional) {
     return strlen(arg); 
 }
 
-bool validate_jobid(char* jobId){
-    if (validate_numerical_arg(jobId, 0)
-            && (atoi(jobId) < childList->numChildren)) {
+bool validate_int_arg(char* arg, int* value) {
+    // skip leading whitespace, as validate_numerical_arg() does
+    while (arg[0] == ' ') {
+        arg++;
+    }
+
+    // digits are accumulated as they are checked, so arg is only scanned once
+    *value = 0;
+    for (int i = 0; arg[i]; i++) {
+        int digit = arg[i] - '0';
+        if (!isdigit(arg[i]) || *value > (INT_MAX - digit) / 10) {
+            return false;
+        }
+        *value = *value * 10 + digit;
+    }
+
+    return arg[0];
+}
+
+bool validate_jobid(char* jobId, Child** child) {
+    int value;
+    if (validate_int_arg(jobId, &value)
+            && (*child = get_child_by_jobid(value))) {
         return true;
     }
     printf("Error: Invalid job\n");
-    fflush(stdout);
+    flush_output();
+    return false;
+}
+
+bool validate_pool(char* name, int* poolId) {
+    if ((*poolId = get_pool_id(name)) < 0) {
+        printf("Error: Invalid pool\n");
+        flush_output();
+        return false;
+    }
+    return true;
+}
+
+bool validate_started(Child* child) {
+    if (is_child_queued(child)) {
+        printf("Error: Job not started\n");
+        flush_output();
+        return false;
+    }
+    return true;
+}
+
+bool validate_group_name(char* name) {
+    if (!isdigit(name[0]) && strcmp(name, SIGNAL_ALL_JOBS)) {
+        return true;
+    }
+    printf("Error: Invalid group\n");
+    flush_output();
     return false;
 }
 
-bool validate_signum(char* signum) {
-    if (validate_numerical_arg(signum, 0)
-            && atoi(signum) >= 1 && atoi(signum) <= 31) {
+bool validate_signum(char* arg, int* signum) {
+    if (validate_int_arg(arg, signum) && *signum >= 1 && *signum <= 31) {
         return true;
     }
     printf("Error: Invalid signal\n");
-    fflush(stdout);
+    flush_output();
     return false;
 }
 
@@ -2,102 +2,360 @@
 #define HQ_H
 
 #include "child.h"
+#include "event.h"
+#include "launch.h"
+#include "report.h"
 
 #include <signal.h>
 #include <stdbool.h>
 #include <sys/types.h>
 
+/* Stores the options given to the spawn command. */
+typedef struct {
+    /* Number of identical jobs to create. */
+    int count;
+    /* Name of the group the new jobs join. */
+    char* groupName;
+    /* Index, within the command's arguments, of the program to run. */
+    int programIndex;
+    /* Limits and placement applied to each new job. The cgroup descriptor is
+     * only opened once the options are valid. */
+    LaunchLimits limits;
+    /* Whether each new job is pinned to the next CPU in turn, rather than to
+     * the CPUs in limits. */
+    bool roundRobin;
+    /* Directory of the cgroup the new jobs join, or NULL to stay in hq's. */
+    char* cgroupPath;
+} SpawnOptions;
+
+/* Stores the options given to the queue command. */
+typedef struct {
+    /* Number of identical jobs to queue. */
+    int count;
+    /* Priority of the new jobs; higher priorities start first. */
+    int priority;
+    /* Name of the queue the new jobs join. */
+    char* queueName;
+    /* New concurrency limit of the queue, or -1 to leave it unchanged. */
+    int limit;
+    /* Name of the group the new jobs join once started. */
+    char* groupName;
+    /* Index, within the command's arguments, of the program to run. */
+    int programIndex;
+} QueueOptions;
+
+/* Stores the options given to the report command. */
+typedef struct {
+    /* Job to report on, or NULL to report on every job. */
+    Child* child;
+    /* Whether to finish with a readout of descriptor usage. */
+    bool showDescriptors;
+    /* Whether to only report on jobs which have changed since every job was
+     * last reported on. */
+    bool changedOnly;
+    /* Format in which to report. */
+    ReportFormat format;
+    /* Whether a text report includes each job's resource usage. */
+    bool showStats;
+} ReportOptions;
+
+/*
+ * Parses hq's command line, which may contain --batch, to run in batch mode,
+ * and -f <script>, to run the commands in the given script file (also in batch
+ * mode) instead of those read from standard input. The script's path is
+ * stored in scriptPath.
+ *
+ * Returns true if the command line is valid; false otherwise.
+ */
+bool parse_command_line(int argc, char** argv, char** scriptPath);
+
+/*
+ * Reads commands from standard input and runs them until end of file is
+ * reached, prompting for each command unless in batch mode.
+ */
+void run_commands();
+
 /*
- * Sets handlers to ignore the interrupt and broken pipe signals and reap
- * child process upon receiving the child signal.
+ * Runs each command in the script file at the given path, in order. The file
+ * is mapped into memory and split into commands in place rather than read
+ * line by line, and child events are handled every few commands rather than
+ * between each.
+ *
+ * Returns true if the script could be read; false otherwise.
+ */
+bool run_script(char* path);
+
+/*
+ * Prints a prompt for the next command, unless in batch mode.
+ */
+void prompt();
+
+/*
+ * Flushes command output to standard output, unless in batch mode, where it
+ * is left buffered until the buffer fills or hq exits.
+ */
+void flush_output();
+
+/*
+ * Sets handlers to ignore the interrupt and broken pipe signals. Child
+ * processes are reaped by the event loop rather than a signal handler.
  */
 void set_handlers();
 
+/* Signature shared by every command. */
+typedef void (*Command)(int numArgs, char** args);
+
 /*
  * Parses the given command string. If the first argument of the command string
  * is the name of a command, that command is called.
+ *
+ * The command string is split into arguments in place, and the array of
+ * arguments is reused between commands, so no memory is allocated per
+ * command.
  */
 void parse(char* command);
 
 /*
- * Usage: spawn <program> [<arg1>] [<arg2>] ...
+ * Returns the command with the given name, or a NULL pointer if there is no
+ * command with the given name. Commands are found with a switch on the name's
+ * length and first character, followed by a single string comparison.
+ */
+Command find_command(char* name);
+
+/*
+ * Usage: spawn [-n <count>] [--group <name>] [--cpu <list>|rr] [--nice <n>]
+ *        [--rlimit-as <MiB>] [--rlimit-cpu <seconds>] [--cgroup <path>]
+ *        <program> [<arg1>] [<arg2>] ...
  *
  * Runs the given program in a new process, with the arguments provided, if
  * any. Arguments or program names containing spacesmay be quoted in double
  * quotes. Standard input to and output from the new proceed can be accessed
  * with the send and rcv commands, respectively. The new process's standard
- * error is linked to this process's standard error, by default.
+ * error is linked to this process's standard error, by default. The new
+ * process does not inherit the pipes of any other job.
+ *
+ * If -n is given, count identical jobs are created in one batch and the range
+ * of new job IDs is printed once.
+ *
+ * The new process joins the named group (the "default" group, if no name is
+ * given). Each group's jobs share a process group, so the signal command can
+ * signal a whole group at once.
+ *
+ * The remaining options limit or place each new job before its program runs:
+ *  - --cpu pins it to the CPUs in the given list (e.g. "0-3,6"), or with "rr"
+ *    to a single CPU, taking each of hq's CPUs in turn across jobs and
+ *    commands, so a batch of jobs is spread evenly over the machine;
+ *  - --nice sets its niceness;
+ *  - --rlimit-as and --rlimit-cpu set its address space and CPU time limits;
+ *    and
+ *  - --cgroup moves it into the cgroup (v2) with the given directory.
+ * A job which cannot be given its limits exits with status 99, as if its
+ * program could not be executed. Jobs with limits are created with fork(),
+ * which costs more than the usual posix_spawnp() as hq's memory use grows.
  */
 void spawn(int numArgs, char** args);
 
 /*
  * Determines whether the given command string is valid to execute the spawn
- * command.
+ * command, storing the options it gives in options.
+ *
+ * The command string is valid if and only if:
+ *  - <program> is present;
+ *  - if -n is given, <count> is a complete and valid integer from 1 to
+ *    1000000;
+ *  - if --group is given, <name> is a valid group name;
+ *  - if --cpu is given, its value is "rr" or a list of CPUs hq may run on;
+ *  - if --nice is given, <n> is an integer from -20 to 19; and
+ *  - if --rlimit-as or --rlimit-cpu are given, their values are valid
+ *    positive integers.
+ * A cgroup's path is only checked when the jobs are spawned.
+ *
+ * All extraneous arguments are ignored.
+ *
+ * Returns true if the command string is valid; false otherwise.
+ */
+bool validate_spawn_args(int numArgs, char** args, SpawnOptions* options);
+
+/*
+ * Usage: pool <name> <size> <program> [<arg1>] [<arg2>] ...
+ *
+ * Creates a pool of size identical, long-lived jobs (workers) running the
+ * given program, like spawn -n. Tasks are sent to the pool, rather than a
+ * particular worker, with send pool:<name>, and results are collected with
+ * rcv pool:<name>, so a stream of short tasks costs a pipe round trip each
+ * rather than a process creation. The workers are ordinary jobs, which also
+ * form a group with the pool's name.
+ */
+void pool(int numArgs, char** args);
+
+/*
+ * Determines whether the given command string is valid to execute the pool
+ * command, storing the number of workers in size.
  *
  * The command string is valid if and only if:
+ *  - <name> is a valid group name, and no pool has that name;
+ *  - <size> is a complete and valid integer from 1 to 1000000; and
  *  - <program> is present.
  *
  * All extraneous arguments are ignored.
  *
  * Returns true if the command string is valid; false otherwise.
  */
-bool validate_spawn_args(int numArgs, char** args);
+bool validate_pool_args(int numArgs, char** args, int* size);
 
 /*
- * Usage: report [<jobid>]
+ * Usage: queue [-n <count>] [--group <name>] [--priority <n>]
+ *        [--queue <name>] [--limit <n>] <program> [<arg1>] [<arg2>] ...
+ *
+ * Queues the given program to run, like the spawn command, once there is
+ * capacity for it. At most the concurrency setting's number of queued jobs
+ * (from all queues) run at once; as each is reaped, the next is started in
+ * its place. Jobs are given job IDs, and reported on as "queued", as soon as
+ * they are queued.
+ *
+ * If -n is given, count identical jobs are queued in one batch and the range
+ * of new job IDs is printed once.
+ *
+ * Jobs wait in the named queue (the "default" queue, if no name is given).
+ * Whenever a job can start, the job with the highest priority (0, if not
+ * given) at the front of any queue which is under its limit is started, and
+ * jobs of equal priority start in the order they were queued. If --limit is
+ * given, at most <n> of the queue's jobs run at once from then on (0 removes
+ * the limit). Capacity a limited queue cannot use is used by the other
+ * queues.
+ *
+ * The new jobs join the named group (the "default" group, if no name is
+ * given) when they start. Input cannot be sent to a job, and its output
+ * cannot be piped, until it has started. Queued jobs which have not started
+ * by cleanup never start, and are reported as signalled(9). A job whose
+ * pipes or process cannot be created when its turn comes is reported as
+ * exited(99), as though its program could not be executed.
+ */
+void queue(int numArgs, char** args);
+
+/*
+ * Determines whether the given command string is valid to execute the queue
+ * command, storing the options it gives in options.
+ *
+ * The command string is valid if and only if:
+ *  - <program> is present;
+ *  - if -n is given, <count> is a complete and valid integer from 1 to
+ *    1000000;
+ *  - if --group is given, <name> is a valid group name; and
+ *  - if --priority or --limit are given, <n> is a complete and valid
+ *    non-negative integer.
+ *
+ * All extraneous arguments are ignored.
+ *
+ * Returns true if the command string is valid; false otherwise.
+ */
+bool validate_queue_args(int numArgs, char** args, QueueOptions* options);
+
+/*
+ * Usage: report [--fds] [--changed] [--stats] [--format=text|json|binary]
+ *        [<jobid>]
  *
  * Reports on the status of the job with the given job ID or all jobs if the
- * jobid parameter is not provided.
+ * jobid parameter is not provided. Jobs evicted under the retention settings
+ * are left out.
+ *
+ * If --changed is given, only jobs which have been spawned or have changed
+ * status since all jobs were last reported on (by this command without a job
+ * ID) are reported on, and the job ID is ignored. Changed jobs are tracked as
+ * they change, so this takes time proportional to the number of changes
+ * rather than the number of jobs.
+ *
+ * If --format is given, jobs are reported in the given format, as described
+ * by ReportFormat. The JSON and binary formats also carry each job's process
+ * ID, start and end times, CPU time and the number of bytes sent to and
+ * received from it, and are written with a single write() call.
+ *
+ * If --stats is given, each job's status line is followed by its CPU time,
+ * memory use, context switches and the bytes and lines sent to and received
+ * from it. CPU time and memory are as reported when the job was reaped, or
+ * as last sampled (see the samplems setting) while it runs.
+ *
+ * If --fds is given, the report ends with a readout of this process's
+ * descriptor usage and the number of jobs retained and evicted.
  */
 void report(int numArgs, char** args);
 
 /*
  * Determines whether the given command string is valid to execute the report
- * command.
+ * command, storing the options it gives in options.
  *
  * The command string is valid if and only if:
  *  - <jobid> is either not present or is a complete and valid integer
- *    corresponding to the job ID of a process created using the spawn command.
+ *    corresponding to the job ID of a process created using the spawn command
+ *    which has not been evicted.
  *
  * All extraneous arguments are ignored.
  *
  * Returns true if the command string is valid; false otherwise.
  */
-bool validate_report_args(int numArgs, char** args);
+bool validate_report_args(int numArgs, char** args, ReportOptions* options);
+
+/*
+ * Determines whether the given name is the name of a report format, storing
+ * the format in format.
+ *
+ * Returns true if the name is "text", "json" or "binary"; false otherwise.
+ */
+bool validate_report_format(char* name, ReportFormat* format);
 
 /*
- * Usage: signal <jobid> <signum>
+ * Prints the number of descriptors this process has open, its limit on open
+ * descriptors, and the number of jobs retained and evicted.
+ */
+void report_descriptors();
+
+/*
+ * Usage: signal <jobid>|<first>-<last>|all|<group> <signum>
  *
- * Send the signal with the given signum to the job with the given job ID.
+ * Send the signal with the given signum to the job with the given job ID,
+ * every running job with a job ID from first to last (inclusive), every
+ * running job, or every running job in the named group. Jobs which are
+ * still queued have no process, and are not signalled.
+ *
+ * Signalling all jobs or a group takes a single kill() call per group, on
+ * the group's process group.
  */
 void send_signal(int numArgs, char** args);
 
 /*
  * Determines whether the given command string is valid to execute the signal
- * command.
+ * command. The job IDs of a single job or range of jobs are stored in
+ * firstJobId and lastJobId. The ID of a named group is stored in groupId,
+ * which is set to -1 if no group was named. The signal number is stored in
+ * signum.
  *
  * The command string is valid if and only if:
- *  - <jobid> is a complete and valid integer corresponding to a process
- *    created using the spawn command; and
+ *  - the target is "all", the name of a group, a complete and valid integer
+ *    corresponding to a process created using the spawn command, or a range
+ *    of complete and valid integers, the first no greater than the last,
+ *    which includes at least one such process (either end may be a job
+ *    which has been evicted, or never existed); and
  *  - <signum> is a complete and valid integer between 1 and 31, inclusive.
  *
  * All extraneous arguments are ignored.
  *
  * Returns true if the command string is valid; false otherwise.
  */
-bool validate_signal_args(int numArgs, char** args);
+bool validate_signal_args(int numArgs, char** args, int* firstJobId,
+        int* lastJobId, int* groupId, int* signum);
 
 /*
  * Usage: sleep <seconds>
  *
  * Causes this process to sleep for the given number of seconds. The specified
- * number of seconds can be integral or fractional.
+ * number of seconds can be integral or fractional, and is slept precisely.
+ * Jobs' pipes, transfers and exits continue to be handled while sleeping.
  */
 void sleep_hq(int numArgs, char** args);
 
 /*
  * Determines whether the given command string is valid to execute the sleep
- * command.
+ * command, storing the number of seconds to sleep for in seconds.
  *
  * The command string is valid if and only if:
  *  - <seconds> is a complete and valid non-negative number.
@@ -106,64 +364,229 @@ void sleep_hq(int numArgs, char** args);
  *
  * Returns true if the command string is valid; false otherwise.
  */
-bool validate_sleep_args(int numArgs, char** args);
+bool validate_sleep_args(int numArgs, char** args, double* seconds);
+
+/*
+ * Usage: wait <jobid> [<timeout>]
+ *
+ * Handles events until the job with the given job ID has exited or been
+ * terminated by a signal, or until timeout seconds (which can be fractional)
+ * have passed, if given. If the timeout passes first, "<timeout>" is
+ * displayed.
+ */
+void wait_job(int numArgs, char** args);
+
+/*
+ * Usage: waitoutput <jobid> [<timeout>]
+ *
+ * Handles events until a line of output from the job with the given job ID is
+ * available to the rcv command, or the job's output has ended, or until
+ * timeout seconds (which can be fractional) have passed, if given. If the
+ * timeout passes first, "<timeout>" is displayed.
+ */
+void wait_output(int numArgs, char** args);
 
 /*
- * Usage: send <jobid> <text>
+ * Determines whether the given command string is valid to execute the wait
+ * or waitoutput command, storing the job it names in child and its timeout
+ * in timeout (-1 if no timeout is given).
+ *
+ * The command string is valid if and only if:
+ *  - <jobid> is a complete and valid integer corresponding to the job ID of a
+ *    process created using the spawn command; and
+ *  - <timeout>, if present, is a complete and valid non-negative number.
+ *
+ * All extraneous arguments are ignored.
+ *
+ * Returns true if the command string is valid; false otherwise.
+ */
+bool validate_wait_args(int numArgs, char** args, Child** child,
+        double* timeout);
+
+/*
+ * Handles events until the given condition holds for the given child or the
+ * given number of seconds pass (if timeout is non-negative), displaying
+ * "<timeout>" if the timeout passes first.
+ */
+void wait_for_child(Child* child, double timeout, EventCondition condition);
+
+/*
+ * Returns true if the given child has been reaped; false otherwise.
+ */
+bool has_exited(Child* child);
+
+/*
+ * Returns true if a line of the given child's output is ready to be received,
+ * its output has ended or its buffer is full (in which case rcv reads a line
+ * from the pipe itself); false otherwise.
+ */
+bool has_output(Child* child);
+
+/*
+ * Usage: send <jobid>|pool:<name> <text>
  *
  * Sends the given text to the job with the given job ID. Strings containing
  * spaces must be quoted in double quotes.
+ *
+ * If a pool is named, the text is sent to the pool's least-loaded worker:
+ * the one with the fewest lines sent to it and not yet received from it by
+ * rcv, taking turns among equally loaded workers.
+ *
+ * The text is queued and written in a batch with other queued text, either
+ * once the amount queued for the job reaches the hwm setting or before this
+ * process next waits for input. Text the job has no room for stays queued
+ * until the job reads, so this never blocks.
  */
 void send(int numArgs, char** args);
 
 /*
  * Determines whether the given command string is valid to execute the send
- * command.
+ * command, storing the job it names in child.
  *
  * The command string is valid if and only if:
  *  - <jobid> is a complete and valid integer corresponding to the job ID of a
- *    process created using the spawn command; and
- * - <text> is present.
+ *    process created using the spawn command, which has started, or the
+ *    named pool exists and has a worker which can be sent to;
+ *  - <text> is present; and
+ *  - no sendfile or pipe into the job is in progress.
+ *
+ * All extraneous arguments are ignored.
+ *
+ * Returns true if the command string is valid; false otherwise.
+ */
+bool validate_send_args(int numArgs, char** args, Child** child);
+
+/*
+ * Usage: flush <jobid>
+ *
+ * Writes as much of the text queued for the job with the given job ID as the
+ * job has room for, without waiting for the batch to fill. Any remainder is
+ * written as the job reads.
+ */
+void flush(int numArgs, char** args);
+
+/*
+ * Determines whether the given command string is valid to execute the flush
+ * command, storing the job it names in child.
+ *
+ * The command string is valid if and only if:
+ *  - <jobid> is a complete and valid integer corresponding to the job ID of a
+ *    process created using the spawn command.
+ *
+ * All extraneous arguments are ignored.
+ *
+ * Returns true if the command string is valid; false otherwise.
+ */
+bool validate_flush_args(int numArgs, char** args, Child** child);
+
+/*
+ * Usage: sendfile <jobid> <path>
+ *
+ * Sends the contents of the file at the given path to the job with the given
+ * job ID. The contents are moved by the kernel without being copied through
+ * this process. If the job cannot accept all of the contents immediately, the
+ * rest is sent in the background as the job reads, without blocking further
+ * commands.
+ */
+void send_file(int numArgs, char** args);
+
+/*
+ * Determines whether the given command string is valid to execute the
+ * sendfile command, storing the job it names in child.
+ *
+ * The command string is valid if and only if:
+ *  - <jobid> is a complete and valid integer corresponding to the job ID of a
+ *    process created using the spawn command;
+ *  - <path> is present; and
+ *  - no earlier sendfile or pipe into the same job is still in progress.
+ *
+ * All extraneous arguments are ignored.
+ *
+ * Returns true if the command string is valid; false otherwise.
+ */
+bool validate_send_file_args(int numArgs, char** args, Child** child);
+
+/*
+ * Usage: pipe <srcjob> <dstjob>
+ *
+ * Connects the standard output of the job with job ID srcjob to the standard
+ * input of the job with job ID dstjob. Output is moved between the jobs by
+ * the kernel as it is produced, without being copied through this process,
+ * and dstjob receives EOF once srcjob's output ends. Output already read from
+ * srcjob remains available to the rcv command.
+ */
+void pipe_jobs(int numArgs, char** args);
+
+/*
+ * Determines whether the given command string is valid to execute the pipe
+ * command, storing the jobs it names in source and target.
+ *
+ * The command string is valid if and only if:
+ *  - <srcjob> and <dstjob> are complete and valid integers corresponding to
+ *    the job IDs of two different processes created using the spawn command;
+ *  - srcjob's output has not ended;
+ *  - srcjob's output is not already piped into another job; and
+ *  - no sendfile or pipe into dstjob is already in progress.
  *
  * All extraneous arguments are ignored.
  *
  * Returns true if the command string is valid; false otherwise.
  */
-bool validate_send_args(int numArgs, char** args);
+bool validate_pipe_args(int numArgs, char** args, Child** source,
+        Child** target);
 
 /*
- * Usage: rcv <jobid>
+ * Usage: rcv <jobid>|pool:<name> [<maxlines>|all]
  *
- * Attempts to read one line of text from the job with the given job ID and
- * displays it to this process's standard out.
+ * Attempts to read up to maxlines lines of text (one line, by default, or
+ * every available line if "all" is given) from the job with the given job ID
+ * and displays them to this process's standard out, followed by "<EOF>" if
+ * the job's output has ended. If no line is available, "<no input>" is
+ * displayed instead.
+ *
+ * If a pool is named, lines are received from each of its workers in turn,
+ * starting after the worker last received from, and "<EOF>" is only shown
+ * once every worker's output has ended.
+ *
+ * Output is drained from jobs by the event loop as soon as it arrives and
+ * read ahead in large chunks, so this never blocks. Lines are split in place
+ * within the job's buffer, so no memory is allocated per line.
  */
 void rcv(int numArgs, char** args);
 
 /*
  * Determines whether the given command string is valid to execute the rcv
- * command.
+ * command, storing the job it names in child (or NULL if it names a pool, in
+ * which case the pool's ID is stored in poolId) and the maximum number of
+ * lines to receive in maxLines (INT_MAX if "all" is given).
  *
  * The command string is valid if and only if:
  *  - <jobid> is a complete and valid integer corresponding to the job ID of a
- *    process created using the spawn command.
+ *    process created using the spawn command, or the named pool exists; and
+ *  - <maxlines>, if present, is either "all" or a complete and valid positive
+ *    integer.
  *
  * All extraneous arguments are ignored.
  *
  * Returns true if the command string is valid; false otherwise.
  */
-bool validate_rcv_args(int numArgs, char** args);
+bool validate_rcv_args(int numArgs, char** args, Child** child, int* poolId,
+        int* maxLines);
 
 /*
  * Usage: eof <jobid>
  *
  * Closes the pipe connected to the standard input of the job with the given
- * job ID, causing it to receive EOF on its next read attempt.
+ * job ID, causing it to receive EOF on its next read attempt. Text already
+ * sent to the job is delivered first, as is the rest of any sendfile still in
+ * progress to the job. If another job is piped into it, the pipe is closed
+ * once that job's output ends.
  */
 void eof(int numArgs, char** args);
 
 /*
  * Determines whether the given command string is valid to execute the eof
- * command.
+ * command, storing the job it names in child.
  *
  * The command string is valid if and only if:
  *  - <jobid> is a complete and valid integer corresponding to the job ID of a
@@ -173,16 +596,75 @@ void eof(int numArgs, char** args);
  *
  * Returns true if the command string is valid; false otherwise.
  */
-bool validate_eof_args(int numArgs, char** args);
+bool validate_eof_args(int numArgs, char** args, Child** child);
 
 /*
  * Usage: cleanup()
  *
  * Terminates and reaps all child processes spawned by this process by sending
- * them the kill signal.
+ * them the kill signal. Blocks until every killed child has been reaped, so
+ * no zombies are left behind.
  */
 void cleanup();
 
+/*
+ * Runs the cleanup command, ignoring any arguments.
+ */
+void cleanup_hq(int numArgs, char** args);
+
+/*
+ * Usage: set <setting> <value>
+ *
+ * Changes one of this process's tunable settings. The available settings are:
+ *  - pipesize: the capacity, in bytes, of the pipes created for each new job
+ *    (0, the default, uses the system default);
+ *  - hwm: the number of bytes which may be queued for a job by the send
+ *    command before they are written (0 writes every send immediately; 64
+ *    KiB by default);
+ *  - maxoutput: the number of bytes of a job's output which may be buffered
+ *    before hq stops reading from the job, so that the job blocks until rcv
+ *    consumes some (0 places no limit; 4 MiB by default);
+ *  - retain: the number of finished jobs kept before the oldest are evicted
+ *    (0, the default, keeps every job);
+ *  - retainsecs: the number of seconds a finished job is kept before it is
+ *    evicted (0, the default, keeps jobs indefinitely);
+ *  - watch: whether each job is reported on, in the format of the report
+ *    command, as soon as it is reaped (0, the default, turns this off);
+ *  - samplems: the number of milliseconds between samples of running jobs'
+ *    CPU time and memory from /proc (0, the default, turns sampling off);
+ *    and
+ *  - concurrency: the number of jobs from the queue command which may run
+ *    at once (0 places no limit; the number of CPUs by default).
+ *
+ * A job is finished once it has been reaped and its output has reached end
+ * of file. Evicted jobs no longer appear in reports, and their job IDs are
+ * no longer valid; new jobs never reuse their job IDs.
+ */
+void set(int numArgs, char** args);
+
+/*
+ * Determines whether the given command string is valid to execute the set
+ * command, storing a pointer to the named setting in setting and its new
+ * value in value.
+ *
+ * The command string is valid if and only if:
+ *  - <setting> is the name of an available setting; and
+ *  - <value> is a complete and valid non-negative integer.
+ *
+ * All extraneous arguments are ignored.
+ *
+ * Returns true if the command string is valid; false otherwise.
+ */
+bool validate_set_args(int numArgs, char** args, int** setting,
+        int* value);
+
+/*
+ * Returns a pointer to the value of the setting with the given name, which
+ * can be changed with the set command; a NULL pointer is returned if there is
+ * no setting with the given name.
+ */
+int* get_setting(char* name);
+
 /*
  * Determines whether the given number of arguments is valid, given the
  * expected number of arguments.
@@ -201,23 +683,59 @@ bool validate_num_args(int minExpected, int given);
  */
 bool validate_numerical_arg(char* arg, int allowFractional);
 
+/*
+ * Determines whether the given argument represents a complete and valid
+ * non-negative integer which fits in an int, storing its value in value. The
+ * argument is checked and converted in a single pass.
+ *
+ * Returns true if and only if arg is a valid and complete integer argument;
+ * false otherwise.
+ */
+bool validate_int_arg(char* arg, int* value);
+
 /*
  * Determines whether the given integer is a valid job ID. A valid job ID is
  * one which corresponds to a child in the given ChildList, created using the
- * spawn command.
+ * spawn command and not since evicted. The child is stored in child.
  *
  * Returns true if and only if arg represents the job ID of a child of this
  * process; false otherwise.
  */
-bool validate_jobid(char* jobId);
+bool validate_jobid(char* jobId, Child** child);
+
+/*
+ * Determines whether the given name is the name of a pool, storing the pool's
+ * ID in poolId.
+ *
+ * Returns true if and only if a pool has the given name; false otherwise.
+ */
+bool validate_pool(char* name, int* poolId);
+
+/*
+ * Determines whether the given job has been started, rather than still being
+ * queued.
+ *
+ * Returns true if and only if the job has been started; false otherwise.
+ */
+bool validate_started(Child* child);
+
+/*
+ * Determines whether the given name can be used as a group name. A group name
+ * is valid if and only if it does not begin with a digit (so it cannot be
+ * mistaken for a job ID) and is not "all".
+ *
+ * Returns true if and only if name is a valid group name; false otherwise.
+ */
+bool validate_group_name(char* name);
 
 /*
- * Determines whether the given integer is a valid signal number. A signal
- * number is valid if and only if it is between 1 and 31, inclusive.
+ * Determines whether the given integer is a valid signal number, storing it
+ * in signum. A signal number is valid if and only if it is between 1 and 31,
+ * inclusive.
  *
  * Returns true if and only if arg is a valid signal number; false otherwise.
  */
-bool validate_signum(char* signum);
+bool validate_signum(char* arg, int* signum);
 
 #endif
 
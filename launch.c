@@ -0,0 +1,312 @@
+#define _GNU_SOURCE
+
+#include "launch.h"
+#include "settings.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define PIPE_WRITE_END 1
+#define PIPE_READ_END 0
+
+// file, within a cgroup's directory, which processes are written to to join
+// the cgroup
+#define CGROUP_PROCS_FILE "cgroup.procs"
+
+// number of bytes in a MiB
+#define BYTES_PER_MIB (1024 * 1024)
+
+/* Environment passed on to every job. */
+extern char** environ;
+
+/* CPUs hq may run on; read on first use. */
+static cpu_set_t allowedCpus;
+static bool allowedCpusReady = false;
+
+/* CPU to be tried first by the next round-robin pin. */
+static int nextCpu = 0;
+
+/* Attributes shared by every spawn; initialised on first use. */
+static posix_spawnattr_t attributes;
+static bool attributesReady = false;
+
+/*
+ * Returns the spawn attributes used for every job, placing the job in the
+ * process group with the given ID (or a new process group, if it is 0). SIGCHLD
+ * is only blocked in hq so it can be read from a signalfd, so jobs start with
+ * an empty mask.
+ */
+static posix_spawnattr_t* get_attributes(pid_t processGroupId) {
+    if (!attributesReady) {
+        sigset_t mask;
+        sigemptyset(&mask);
+        posix_spawnattr_init(&attributes);
+        posix_spawnattr_setflags(&attributes,
+                POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setsigmask(&attributes, &mask);
+        attributesReady = true;
+    }
+    posix_spawnattr_setpgroup(&attributes, processGroupId);
+    return &attributes;
+}
+
+void init_launch_limits(LaunchLimits* limits) {
+    limits->pinned = false;
+    CPU_ZERO(&limits->cpus);
+    limits->niced = false;
+    limits->niceness = 0;
+    limits->addressSpaceMiB = 0;
+    limits->cpuSeconds = 0;
+    limits->cgroupFd = -1;
+}
+
+bool has_launch_limits(const LaunchLimits* limits) {
+    return limits->pinned || limits->niced || limits->addressSpaceMiB
+            || limits->cpuSeconds || limits->cgroupFd >= 0;
+}
+
+/*
+ * Returns the set of CPUs hq may run on.
+ */
+static const cpu_set_t* get_allowed_cpus() {
+    if (!allowedCpusReady) {
+        if (sched_getaffinity(0, sizeof(allowedCpus), &allowedCpus)) {
+            CPU_ZERO(&allowedCpus);
+            CPU_SET(0, &allowedCpus);
+        }
+        allowedCpusReady = true;
+    }
+    return &allowedCpus;
+}
+
+bool parse_cpu_list(char* list, cpu_set_t* cpus) {
+    const cpu_set_t* allowed = get_allowed_cpus();
+    CPU_ZERO(cpus);
+    char* range = list;
+    while (true) {
+        // strtol() accepts signs and spaces, which a CPU list does not
+        if (!isdigit(range[0])) {
+            return false;
+        }
+        char* end;
+        long first = strtol(range, &end, 10);
+        long last = first;
+        if (end[0] == '-') {
+            if (!isdigit(end[1])) {
+                return false;
+            }
+            last = strtol(end + 1, &end, 10);
+        }
+        if (first > last || last >= CPU_SETSIZE) {
+            return false;
+        }
+
+        for (long cpu = first; cpu <= last; cpu++) {
+            if (!CPU_ISSET(cpu, allowed)) {
+                return false;
+            }
+            CPU_SET(cpu, cpus);
+        }
+
+        if (!end[0]) {
+            return true;
+        } else if (end[0] != ',') {
+            return false;
+        }
+        range = end + 1;
+    }
+}
+
+void next_round_robin_cpu(cpu_set_t* cpus) {
+    const cpu_set_t* allowed = get_allowed_cpus();
+    while (!CPU_ISSET(nextCpu, allowed)) {
+        nextCpu = (nextCpu + 1) % CPU_SETSIZE;
+    }
+    CPU_ZERO(cpus);
+    CPU_SET(nextCpu, cpus);
+    nextCpu = (nextCpu + 1) % CPU_SETSIZE;
+}
+
+int open_cgroup(const char* path) {
+    char procsPath[PATH_MAX];
+    if (snprintf(procsPath, sizeof(procsPath), "%s/%s", path,
+            CGROUP_PROCS_FILE) >= (int) sizeof(procsPath)) {
+        return -1;
+    }
+    return open(procsPath, O_WRONLY | O_CLOEXEC);
+}
+
+/*
+ * Sets the given resource limit of the calling process, both soft and hard, to
+ * the given value.
+ *
+ * Returns true if the limit was set; false otherwise.
+ */
+static bool set_limit(int resource, rlim_t value) {
+    struct rlimit limit = {value, value};
+    return !setrlimit(resource, &limit);
+}
+
+/*
+ * Applies the given limits to the calling process, which is a new job that
+ * has not yet executed its program.
+ *
+ * Returns true if every limit was applied; false otherwise.
+ */
+static bool apply_launch_limits(const LaunchLimits* limits) {
+    // join the cgroup first, so that everything after is accounted to it;
+    // writing 0 to cgroup.procs moves the writing process
+    if (limits->cgroupFd >= 0 && write(limits->cgroupFd, "0", 1) != 1) {
+        return false;
+    }
+    if (limits->pinned && sched_setaffinity(0, sizeof(limits->cpus),
+            &limits->cpus)) {
+        return false;
+    }
+    if (limits->niced && setpriority(PRIO_PROCESS, 0, limits->niceness)) {
+        return false;
+    }
+    if (limits->addressSpaceMiB && !set_limit(RLIMIT_AS,
+            (rlim_t) limits->addressSpaceMiB * BYTES_PER_MIB)) {
+        return false;
+    }
+    if (limits->cpuSeconds && !set_limit(RLIMIT_CPU, limits->cpuSeconds)) {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Places the calling process in the process group with the given ID, or a
+ * new process group led by the calling process if it is 0 or the given
+ * process group can no longer be joined.
+ */
+static void join_process_group(pid_t processGroupId) {
+    if (setpgid(0, processGroupId) && processGroupId) {
+        setpgid(0, 0);
+    }
+}
+
+/*
+ * Creates a process with fork() which applies the given limits and then
+ * executes the program named by args[0], with the given standard input and
+ * output, in the process group with the given ID (or a new process group, if
+ * it is 0).
+ *
+ * Returns the process ID of the new process, or -1 if it could not be
+ * created.
+ */
+static pid_t launch_with_limits(char** args, pid_t processGroupId,
+        const LaunchLimits* limits, int input, int output) {
+    pid_t processId = fork();
+    if (processId) {
+        // also set in the parent, so the job can be signalled as part of its
+        // group as soon as fork() returns
+        if (processId > 0 && setpgid(processId,
+                processGroupId ? processGroupId : processId)
+                && processGroupId) {
+            setpgid(processId, processId);
+        }
+        return processId;
+    }
+
+    join_process_group(processGroupId);
+    dup2(input, STDIN_FILENO);
+    dup2(output, STDOUT_FILENO);
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigprocmask(SIG_SETMASK, &mask, NULL);
+    if (apply_launch_limits(limits)) {
+        execvp(args[0], args);
+    }
+    _exit(EXIT_EXEC_FAIL);
+}
+
+/*
+ * Creates a process which exits immediately with status EXIT_EXEC_FAIL,
+ * standing in for a job whose program could not be executed. The process
+ * joins the process group with the given ID (or leads a new one, if it is 0)
+ * like the job would have.
+ *
+ * Returns the process ID of the new process.
+ */
+static pid_t launch_exec_failure(pid_t processGroupId) {
+    pid_t processId = vfork();
+    if (!processId) {
+        join_process_group(processGroupId);
+        _exit(EXIT_EXEC_FAIL);
+    }
+    return processId;
+}
+
+pid_t launch_program(char** args, pid_t processGroupId,
+        const LaunchLimits* limits, int* pToC, int* cToP) {
+    int toChild[2];
+    if (pipe2(toChild, O_CLOEXEC)) {
+        return -1;
+    }
+
+    int fromChild[2];
+    if (pipe2(fromChild, O_CLOEXEC)) {
+        close(toChild[PIPE_READ_END]);
+        close(toChild[PIPE_WRITE_END]);
+        return -1;
+    }
+
+    if (settings.pipeSize) {
+        fcntl(toChild[PIPE_WRITE_END], F_SETPIPE_SZ, settings.pipeSize);
+        fcntl(fromChild[PIPE_WRITE_END], F_SETPIPE_SZ, settings.pipeSize);
+    }
+
+    // dup2() clears close-on-exec on the child's standard I/O descriptors
+    pid_t processId;
+    if (limits && has_launch_limits(limits)) {
+        processId = launch_with_limits(args, processGroupId, limits,
+                toChild[PIPE_READ_END], fromChild[PIPE_WRITE_END]);
+    } else {
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, toChild[PIPE_READ_END],
+                STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, fromChild[PIPE_WRITE_END],
+                STDOUT_FILENO);
+
+        int error = posix_spawnp(&processId, args[0], &actions,
+                get_attributes(processGroupId), args, environ);
+        if (error == EPERM && processGroupId) {
+            // the process group emptied since it was checked, so the job
+            // leads a new one rather than being reported as a bad exec
+            processGroupId = 0;
+            error = posix_spawnp(&processId, args[0], &actions,
+                    get_attributes(processGroupId), args, environ);
+        }
+        if (error) {
+            processId = launch_exec_failure(processGroupId);
+        }
+        posix_spawn_file_actions_destroy(&actions);
+    }
+
+    // close child's ends of pipes
+    close(toChild[PIPE_READ_END]);
+    close(fromChild[PIPE_WRITE_END]);
+    if (processId < 0) {
+        close(toChild[PIPE_WRITE_END]);
+        close(fromChild[PIPE_READ_END]);
+        return -1;
+    }
+
+    *pToC = toChild[PIPE_WRITE_END];
+    *cToP = fromChild[PIPE_READ_END];
+    return processId;
+}
@@ -0,0 +1,95 @@
+#ifndef LAUNCH_H
+#define LAUNCH_H
+
+#include <sched.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+/* Exit status of a job whose program could not be executed. */
+#define EXIT_EXEC_FAIL 99
+
+/* Stores the limits and placement applied to a new job before its program is
+ * executed. */
+typedef struct {
+    /* Whether the job is pinned to the CPUs in cpus. */
+    bool pinned;
+    /* CPUs the job may run on, if pinned is set. */
+    cpu_set_t cpus;
+    /* Whether the job's niceness is set to niceness. */
+    bool niced;
+    /* Niceness given to the job, if niced is set. */
+    int niceness;
+    /* Limit, in MiB, on the job's address space; 0 leaves hq's limit. */
+    int addressSpaceMiB;
+    /* Limit, in seconds, on the job's CPU time; 0 leaves hq's limit. */
+    int cpuSeconds;
+    /* Descriptor for the cgroup.procs file of the cgroup the job joins; -1
+     * leaves the job in hq's cgroup. */
+    int cgroupFd;
+} LaunchLimits;
+
+/*
+ * Initialises the given LaunchLimits to leave a new job with hq's own limits
+ * and placement.
+ */
+void init_launch_limits(LaunchLimits* limits);
+
+/*
+ * Returns true if the given LaunchLimits change anything about a new job;
+ * false otherwise.
+ */
+bool has_launch_limits(const LaunchLimits* limits);
+
+/*
+ * Parses the given CPU list, of CPU numbers and inclusive ranges separated by
+ * commas (e.g. "0-3,6"), into cpus. Every CPU must be one hq may run on.
+ *
+ * Returns true if the list is valid; false otherwise.
+ */
+bool parse_cpu_list(char* list, cpu_set_t* cpus);
+
+/*
+ * Stores in cpus the next CPU, in turn, of those hq may run on, so that jobs
+ * pinned one after another are spread evenly over the CPUs.
+ */
+void next_round_robin_cpu(cpu_set_t* cpus);
+
+/*
+ * Opens the cgroup.procs file of the cgroup with the given directory, so that
+ * jobs can be placed in it.
+ *
+ * Returns the file's descriptor (close-on-exec), or -1 if it cannot be opened
+ * for writing.
+ */
+int open_cgroup(const char* path);
+
+/*
+ * Runs the program named by args[0] in a new process, with the
+ * NULL-terminated argument list args. The new process's standard input and
+ * output are connected to new pipes, whose other ends are stored in pToC
+ * (written to by hq) and cToP (read from by hq). Every pipe descriptor is
+ * created close-on-exec, so no job inherits another job's pipes. If the
+ * pipesize setting is non-zero, both pipes are given that capacity.
+ *
+ * The new process joins the process group with the given ID, or leads a new
+ * process group if processGroupId is 0 or the process group can no longer be
+ * joined, so that it can be signalled together with the rest of its group.
+ *
+ * The process is created with posix_spawnp() rather than fork(), so its cost
+ * does not grow with hq's memory use. If the program cannot be executed, a
+ * process which immediately exits with status EXIT_EXEC_FAIL is created in
+ * its place, so that the failure is reported like any other exit.
+ *
+ * If limits is not NULL and has_launch_limits() holds for it, the process is
+ * instead created with fork() and the limits are applied before the program
+ * is executed, so the program never runs without them. If any limit cannot
+ * be applied (e.g. a negative niceness without privilege), the process exits
+ * with status EXIT_EXEC_FAIL without executing the program.
+ *
+ * Returns the process ID of the new process, or -1 if the pipes or process
+ * could not be created.
+ */
+pid_t launch_program(char** args, pid_t processGroupId,
+        const LaunchLimits* limits, int* pToC, int* cToP);
+
+#endif
@@ -0,0 +1,111 @@
+#include "linebuf.h"
+#include "linescan.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// number of bytes allocated when the buffer is first filled, so that reads
+// are made in large chunks
+#define LINE_BUFFER_INITIAL_CAPACITY 65536
+
+// minimum amount of free space offered to each read() call
+#define LINE_BUFFER_MIN_READ 4096
+
+void init_line_buffer(LineBuffer* buffer) {
+    buffer->data = NULL;
+    buffer->start = 0;
+    buffer->end = 0;
+    buffer->capacity = 0;
+    buffer->eof = false;
+}
+
+ssize_t fill_line_buffer(LineBuffer* buffer, int fd) {
+    // move unconsumed bytes to the front before deciding whether to grow
+    if (buffer->start == buffer->end) {
+        buffer->start = buffer->end = 0;
+    } else if (buffer->start
+            && buffer->capacity - buffer->end <= LINE_BUFFER_MIN_READ) {
+        memmove(buffer->data, buffer->data + buffer->start,
+                buffer->end - buffer->start);
+        buffer->end -= buffer->start;
+        buffer->start = 0;
+    }
+
+    // always keep one spare byte so a final unterminated line can be
+    // null-terminated in place
+    if (buffer->capacity - buffer->end <= LINE_BUFFER_MIN_READ) {
+        size_t capacity = buffer->capacity ? buffer->capacity * 2
+                : LINE_BUFFER_INITIAL_CAPACITY;
+        while (capacity - buffer->end <= LINE_BUFFER_MIN_READ) {
+            capacity *= 2;
+        }
+        buffer->data = realloc(buffer->data, capacity);
+        buffer->capacity = capacity;
+    }
+
+    ssize_t numRead = read(fd, buffer->data + buffer->end,
+            buffer->capacity - buffer->end - 1);
+    if (numRead > 0) {
+        buffer->end += numRead;
+    } else if (!numRead) {
+        buffer->eof = true;
+    }
+
+    return numRead;
+}
+
+char* next_line(LineBuffer* buffer) {
+    if (buffer->start == buffer->end) {
+        return NULL;
+    }
+
+    char* line = buffer->data + buffer->start;
+    char* newline = find_newline(line, buffer->end - buffer->start);
+    if (newline) {
+        *newline = '\0';
+        buffer->start = newline - buffer->data + 1;
+        return line;
+    } else if (buffer->eof) {
+        buffer->data[buffer->end] = '\0';
+        buffer->start = buffer->end;
+        return line;
+    }
+
+    return NULL;
+}
+
+bool has_line(LineBuffer* buffer) {
+    if (buffer->start == buffer->end) {
+        return false;
+    }
+    return buffer->eof || find_newline(buffer->data + buffer->start,
+            buffer->end - buffer->start);
+}
+
+char* next_lines(LineBuffer* buffer, size_t* length) {
+    if (buffer->start == buffer->end) {
+        return NULL;
+    }
+
+    char* lines = buffer->data + buffer->start;
+    char* newline = find_last_newline(lines, buffer->end - buffer->start);
+    if (newline) {
+        *length = newline - lines + 1;
+    } else if (buffer->eof) {
+        buffer->data[buffer->end] = '\n'; // uses the spare byte
+        *length = buffer->end - buffer->start + 1;
+        buffer->start = buffer->end;
+        return lines;
+    } else {
+        return NULL;
+    }
+
+    buffer->start += *length;
+    return lines;
+}
+
+void free_line_buffer(LineBuffer* buffer) {
+    free(buffer->data);
+    init_line_buffer(buffer);
+}
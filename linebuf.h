@@ -0,0 +1,74 @@
+#ifndef LINEBUF_H
+#define LINEBUF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Stores bytes read from a file descriptor until they are consumed as lines. */
+typedef struct {
+    /* Bytes which have been read but not yet consumed. */
+    char* data;
+    /* Offset of the first unconsumed byte in data. */
+    size_t start;
+    /* Offset one past the last byte read into data. */
+    size_t end;
+    /* Number of bytes allocated for data. */
+    size_t capacity;
+    /* Whether end of file has been read from the underlying descriptor. */
+    bool eof;
+} LineBuffer;
+
+/*
+ * Initialises the given LineBuffer to be empty. No memory is allocated until
+ * the buffer is first filled.
+ */
+void init_line_buffer(LineBuffer* buffer);
+
+/*
+ * Performs a single read() from the given file descriptor, appending whatever
+ * is read to the given LineBuffer. Each read is offered all of the buffer's
+ * free space, and the buffer starts at 64 KiB, so chatty sources are drained
+ * in large chunks. The buffer grows as required.
+ *
+ * Returns the number of bytes read, 0 on end of file (in which case the
+ * buffer's eof flag is set) or -1 on error, with errno set by read().
+ */
+ssize_t fill_line_buffer(LineBuffer* buffer, int fd);
+
+/*
+ * Removes the next complete line from the given LineBuffer and returns it,
+ * with its trailing newline replaced by a null terminator. If end of file has
+ * been reached, any trailing bytes without a newline are returned as the final
+ * line.
+ *
+ * The returned string points into the buffer and is only valid until the next
+ * call to fill_line_buffer() or free_line_buffer(). A NULL pointer is returned
+ * if no complete line is available.
+ */
+char* next_line(LineBuffer* buffer);
+
+/*
+ * Returns true if next_line() would return a line from the given LineBuffer;
+ * false otherwise.
+ */
+bool has_line(LineBuffer* buffer);
+
+/*
+ * Removes every complete line from the given LineBuffer and returns them as a
+ * single block, storing its length (including the final newline) in length.
+ * If end of file has been reached, any trailing bytes without a newline are
+ * included, with a newline added after them.
+ *
+ * The returned block points into the buffer and is only valid until the next
+ * call to fill_line_buffer() or free_line_buffer(). A NULL pointer is returned
+ * if no complete line is available.
+ */
+char* next_lines(LineBuffer* buffer, size_t* length);
+
+/*
+ * Frees the memory held by the given LineBuffer, leaving it empty.
+ */
+void free_line_buffer(LineBuffer* buffer);
+
+#endif
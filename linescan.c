@@ -0,0 +1,14 @@
+#define _GNU_SOURCE
+
+#include "linescan.h"
+
+#include <stddef.h>
+#include <string.h>
+
+char* find_newline(const char* bytes, size_t length) {
+    return memchr(bytes, '\n', length);
+}
+
+char* find_last_newline(const char* bytes, size_t length) {
+    return memrchr(bytes, '\n', length);
+}
@@ -0,0 +1,24 @@
+#ifndef LINESCAN_H
+#define LINESCAN_H
+
+#include <stddef.h>
+
+/*
+ * Returns a pointer to the first newline character within the given number of
+ * bytes starting at bytes; a NULL pointer is returned if there is none.
+ *
+ * Uses memchr(), which glibc vectorises for the processor it runs on.
+ */
+char* find_newline(const char* bytes, size_t length);
+
+/*
+ * Returns a pointer to the last newline character within the given number of
+ * bytes starting at bytes; a NULL pointer is returned if there is none.
+ *
+ * The bytes are scanned backwards from the end with memrchr(), so this is
+ * fast when the last newline is near the end, as it is when splitting a block
+ * of input at its last complete line.
+ */
+char* find_last_newline(const char* bytes, size_t length);
+
+#endif
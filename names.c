@@ -0,0 +1,116 @@
+#include "names.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// number of bytes allocated for names when the first is stored
+#define NAME_ARENA_INITIAL_CAPACITY 1024
+
+// number of names there is room for when the first is stored
+#define NAME_TABLE_INITIAL_CAPACITY 16
+
+// FNV-1a parameters, used to hash names
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+void init_name_table(NameTable* table) {
+    table->arena = NULL;
+    table->arenaSize = 0;
+    table->arenaCapacity = 0;
+    table->offsets = NULL;
+    table->numNames = 0;
+    table->capacity = 0;
+    table->slots = NULL;
+    table->numSlots = 0;
+}
+
+/*
+ * Returns the slot of the given NameTable at which probing for the given name
+ * begins.
+ */
+static int name_slot(NameTable* table, const char* name) {
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (const char* c = name; *c; c++) {
+        hash = (hash ^ (unsigned char) *c) * FNV_PRIME;
+    }
+    return hash & (table->numSlots - 1);
+}
+
+/*
+ * Grows the offsets and slots of the given NameTable so there is room for one
+ * more name, re-inserting every stored name into the larger slot table.
+ */
+static void grow_name_table(NameTable* table) {
+    table->capacity = table->capacity ? table->capacity * 2
+            : NAME_TABLE_INITIAL_CAPACITY;
+    table->offsets = realloc(table->offsets,
+            sizeof(size_t) * table->capacity);
+
+    free(table->slots);
+    table->numSlots = table->capacity * 2;
+    table->slots = malloc(sizeof(int) * table->numSlots);
+    memset(table->slots, -1, sizeof(int) * table->numSlots);
+    int mask = table->numSlots - 1;
+    for (int nameId = 0; nameId < table->numNames; nameId++) {
+        int slot = name_slot(table, get_name(table, nameId));
+        while (table->slots[slot] >= 0) {
+            slot = (slot + 1) & mask;
+        }
+        table->slots[slot] = nameId;
+    }
+}
+
+/*
+ * Copies the given name, of the given length (including its null
+ * terminator), to the end of the given NameTable's arena, doubling the arena
+ * as many times as required.
+ *
+ * Returns the offset of the copy within the arena.
+ */
+static size_t append_name(NameTable* table, const char* name, size_t length) {
+    if (table->arenaSize + length > table->arenaCapacity) {
+        size_t capacity = table->arenaCapacity ? table->arenaCapacity
+                : NAME_ARENA_INITIAL_CAPACITY;
+        while (table->arenaSize + length > capacity) {
+            capacity *= 2;
+        }
+        table->arena = realloc(table->arena, capacity);
+        table->arenaCapacity = capacity;
+    }
+
+    size_t offset = table->arenaSize;
+    memcpy(table->arena + offset, name, length);
+    table->arenaSize += length;
+    return offset;
+}
+
+int intern_name(NameTable* table, const char* name) {
+    if (table->numNames == table->capacity) {
+        grow_name_table(table);
+    }
+
+    int mask = table->numSlots - 1;
+    int slot = name_slot(table, name);
+    for (; table->slots[slot] >= 0; slot = (slot + 1) & mask) {
+        if (!strcmp(get_name(table, table->slots[slot]), name)) {
+            return table->slots[slot];
+        }
+    }
+
+    int nameId = table->numNames++;
+    table->offsets[nameId] = append_name(table, name, strlen(name) + 1);
+    table->slots[slot] = nameId;
+    return nameId;
+}
+
+const char* get_name(NameTable* table, int nameId) {
+    return table->arena + table->offsets[nameId];
+}
+
+void free_name_table(NameTable* table) {
+    free(table->arena);
+    free(table->offsets);
+    free(table->slots);
+    init_name_table(table);
+}
@@ -0,0 +1,53 @@
+#ifndef NAMES_H
+#define NAMES_H
+
+#include <stddef.h>
+
+/* Stores each distinct name once, so that many jobs running the same program
+ * share a single copy of its name. */
+typedef struct {
+    /* Every stored name, null-terminated and packed end to end. */
+    char* arena;
+    /* Number of bytes of arena in use. */
+    size_t arenaSize;
+    /* Number of bytes allocated for arena. */
+    size_t arenaCapacity;
+    /* Offset within arena of each stored name, indexed by name ID. */
+    size_t* offsets;
+    /* Number of names being stored. */
+    int numNames;
+    /* Number of offsets allocated. */
+    int capacity;
+    /* Open-addressed (linearly probed) table of name IDs, hashed by name.
+     * Empty slots are -1. */
+    int* slots;
+    /* Number of slots; always a power of two, and at least twice the number
+     * of names. */
+    int numSlots;
+} NameTable;
+
+/*
+ * Initialises the given NameTable to be empty. No memory is allocated until a
+ * name is first stored.
+ */
+void init_name_table(NameTable* table);
+
+/*
+ * Returns the ID of the given name within the given NameTable, storing a copy
+ * of the name first if it is not stored already. IDs are assigned from 0 in
+ * the order names are first stored.
+ */
+int intern_name(NameTable* table, const char* name);
+
+/*
+ * Returns the name with the given ID. The returned string is only valid until
+ * another name is stored in the table.
+ */
+const char* get_name(NameTable* table, int nameId);
+
+/*
+ * Frees the memory held by the given NameTable, leaving it empty.
+ */
+void free_name_table(NameTable* table);
+
+#endif
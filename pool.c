@@ -0,0 +1,88 @@
+#include "child.h"
+#include "pool.h"
+#include "transfer.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// number of pools the pool list has room for before it first grows
+#define INITIAL_POOL_CAPACITY 4
+
+/* Stores every named pool of workers. */
+static WorkerPool* pools = NULL;
+static int numPools = 0;
+/* Number of pools the pools array has room for. */
+static int poolCapacity = 0;
+
+int get_pool_id(const char* name) {
+    for (int i = 0; i < numPools; i++) {
+        if (!strcmp(pools[i].name, name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int add_pool(const char* name, int firstJobId, int numWorkers) {
+    if (numPools == poolCapacity) {
+        poolCapacity = poolCapacity ? poolCapacity * 2 : INITIAL_POOL_CAPACITY;
+        pools = realloc(pools, sizeof(WorkerPool) * poolCapacity);
+    }
+
+    WorkerPool* pool = &pools[numPools];
+    pool->name = strdup(name);
+    pool->firstJobId = firstJobId;
+    pool->numWorkers = numWorkers;
+    pool->nextSend = 0;
+    pool->nextReceive = 0;
+    return numPools++;
+}
+
+WorkerPool* get_pool(int poolId) {
+    return &pools[poolId];
+}
+
+Child* get_pool_worker(int poolId, int index) {
+    return get_child_by_jobid(get_pool(poolId)->firstJobId + index);
+}
+
+Child* choose_pool_worker(int poolId) {
+    WorkerPool* pool = get_pool(poolId);
+    Child* chosen = NULL;
+    uint64_t chosenLoad = 0;
+    int chosenIndex = 0;
+    for (int i = 0; i < pool->numWorkers; i++) {
+        int index = (pool->nextSend + i) % pool->numWorkers;
+        Child* worker = get_pool_worker(poolId, index);
+        if (!worker || !is_child_running(worker) || worker->pToC < 0
+                || worker->closeInput || is_transferring(worker)) {
+            continue;
+        }
+
+        // lines received may exceed those sent by a worker which writes
+        // more than one line per task
+        uint64_t load = worker->linesSent > worker->linesReceived
+                ? worker->linesSent - worker->linesReceived : 0;
+        if (!chosen || load < chosenLoad) {
+            chosen = worker;
+            chosenLoad = load;
+            chosenIndex = index;
+        }
+        if (!load) { // idle, so nothing can be less loaded
+            break;
+        }
+    }
+
+    if (chosen) {
+        pool->nextSend = (chosenIndex + 1) % pool->numWorkers;
+    }
+    return chosen;
+}
+
+void free_pools() {
+    for (int i = 0; i < numPools; i++) {
+        free(pools[i].name);
+    }
+    free(pools);
+}
@@ -0,0 +1,67 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "child.h"
+
+/* Prefix which names a pool, rather than a job, in the send and rcv
+ * commands. */
+#define POOL_PREFIX "pool:"
+
+/* Stores a named pool of identical, long-lived jobs which tasks are sent to
+ * in turn. */
+typedef struct {
+    /* Name of this pool, as given to the pool command. */
+    char* name;
+    /* Job ID of the first worker; the workers have consecutive job IDs. */
+    int firstJobId;
+    /* Number of workers in this pool. */
+    int numWorkers;
+    /* Index of the worker considered first by the next send, so that workers
+     * with equal loads take turns. */
+    int nextSend;
+    /* Index of the worker received from first by the next rcv, so that
+     * every worker's output is collected in turn. */
+    int nextReceive;
+} WorkerPool;
+
+/*
+ * Returns the ID of the pool with the given name, or -1 if there is no such
+ * pool.
+ */
+int get_pool_id(const char* name);
+
+/*
+ * Creates a pool with the given name, whose workers are the given number of
+ * jobs with consecutive job IDs starting from firstJobId.
+ *
+ * Returns the ID of the new pool.
+ */
+int add_pool(const char* name, int firstJobId, int numWorkers);
+
+/*
+ * Returns a pointer to the pool with the given pool ID. The pointer is only
+ * valid until a pool is next created.
+ */
+WorkerPool* get_pool(int poolId);
+
+/*
+ * Returns the worker of the pool with the given ID which the next task should
+ * be sent to: the running worker whose input is open with the fewest lines
+ * sent to it and not yet received from it, taking turns among equals. Workers
+ * with a sendfile or pipe into them in progress are passed over. Returns NULL
+ * if no worker can be sent to.
+ */
+Child* choose_pool_worker(int poolId);
+
+/*
+ * Returns the worker with the given index (from 0) in the pool with the given
+ * ID, or NULL if it has been evicted.
+ */
+Child* get_pool_worker(int poolId, int index);
+
+/*
+ * Frees every pool.
+ */
+void free_pools();
+
+#endif
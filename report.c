@@ -0,0 +1,277 @@
+#include "child.h"
+#include "report.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// number of bytes allocated when a report is first serialised
+#define REPORT_BUFFER_INITIAL_CAPACITY 65536
+
+// longest JSON escape for a single byte, \u00XX
+#define MAX_JSON_ESCAPE 6
+
+// number of bytes in a binary record before its program name, after its
+// length prefix
+#define BINARY_RECORD_FIXED_SIZE 116
+
+// number of microseconds in a second
+#define MICROS_PER_SECOND 1000000
+
+/* Stores a report while it is serialised. */
+typedef struct {
+    /* Bytes serialised so far. */
+    char* data;
+    /* Number of bytes serialised so far. */
+    size_t length;
+    /* Number of bytes allocated for data. */
+    size_t capacity;
+    /* Format of the report being made. */
+    ReportFormat format;
+    /* Whether a text report includes each job's resource usage. */
+    bool showStats;
+    /* Number of jobs added to the report so far. */
+    uint32_t numJobs;
+} ReportBuffer;
+
+/* Buffer shared by every report. */
+static ReportBuffer report = {NULL, 0, 0, REPORT_TEXT, false, 0};
+
+/*
+ * Ensures the report buffer has room for at least the given number of bytes
+ * beyond those already serialised, doubling it as many times as required.
+ *
+ * Returns a pointer to the first free byte.
+ */
+static char* reserve_report(size_t length) {
+    if (report.length + length > report.capacity) {
+        size_t capacity = report.capacity ? report.capacity
+                : REPORT_BUFFER_INITIAL_CAPACITY;
+        while (report.length + length > capacity) {
+            capacity *= 2;
+        }
+        report.data = realloc(report.data, capacity);
+        report.capacity = capacity;
+    }
+    return report.data + report.length;
+}
+
+/*
+ * Formats the given arguments, as printf() would, straight into the end of
+ * the report buffer.
+ */
+static void append_format(const char* format, ...) {
+    reserve_report(1);
+    va_list args;
+    va_start(args, format);
+    size_t room = report.capacity - report.length;
+    int length = vsnprintf(report.data + report.length, room, format, args);
+    va_end(args);
+
+    if ((size_t) length >= room) { // didn't fit, so grow and format again
+        reserve_report(length + 1);
+        va_start(args, format);
+        vsnprintf(report.data + report.length, length + 1, format, args);
+        va_end(args);
+    }
+    report.length += length;
+}
+
+/*
+ * Appends the given string to the report buffer as a quoted JSON string,
+ * escaping quotes, backslashes and control characters.
+ */
+static void append_json_string(const char* string) {
+    char* out = reserve_report(strlen(string) * MAX_JSON_ESCAPE + 2);
+    *out++ = '"';
+    for (const char* c = string; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            *out++ = '\\';
+            *out++ = *c;
+        } else if ((unsigned char) *c < ' ') {
+            out += sprintf(out, "\\u%04x", (unsigned char) *c);
+        } else {
+            *out++ = *c;
+        }
+    }
+    *out++ = '"';
+    report.length = out - report.data;
+}
+
+/*
+ * Writes the given value into out as the given number of little-endian
+ * bytes.
+ *
+ * Returns a pointer to the byte after those written.
+ */
+static char* put_le(char* out, uint64_t value, int numBytes) {
+    for (int i = 0; i < numBytes; i++) {
+        *out++ = (char) (value >> (i * 8));
+    }
+    return out;
+}
+
+void start_report(ReportFormat format, bool showStats) {
+    report.length = 0;
+    report.format = format;
+    report.showStats = showStats;
+    report.numJobs = 0;
+    if (format == REPORT_TEXT) {
+        printf("[Job] cmd:status\n");
+    } else if (format == REPORT_JSON) {
+        append_format("{\"jobs\":[");
+    } else { // the number of jobs is filled in once they have all been added
+        put_le(reserve_report(sizeof(uint32_t)), 0, sizeof(uint32_t));
+        report.length += sizeof(uint32_t);
+    }
+}
+
+/*
+ * Adds the given child to the report buffer as a JSON object.
+ */
+static void add_json(Child* child) {
+    ChildStatus status = get_child_status(child);
+    ChildTimes times = get_child_times(child);
+    static const char* states[] = {"running", "exited", "signalled",
+            "evicted", "queued"};
+
+    append_format("%s{\"job\":%d,\"pid\":%d,\"program\":",
+            report.numJobs ? "," : "", child->jobId, get_child_pid(child));
+    append_json_string(get_child_program(child));
+    append_format(",\"state\":\"%s\"", states[status.state]);
+    if (status.state == CHILD_EXITED) {
+        append_format(",\"code\":%d", status.value);
+    } else if (status.state == CHILD_SIGNALLED) {
+        append_format(",\"signal\":%d", status.value);
+    }
+    append_format(",\"start_us\":%lld", (long long) times.startTime);
+    if (times.endTime) {
+        append_format(",\"end_us\":%lld", (long long) times.endTime);
+    } else {
+        append_format(",\"end_us\":null");
+    }
+    append_format(",\"user_us\":%lld,\"system_us\":%lld,\"sent\":%llu,"
+            "\"received\":%llu,\"lines_sent\":%llu,\"lines_received\":%llu",
+            (long long) times.userTime, (long long) times.systemTime,
+            (unsigned long long) child->bytesSent,
+            (unsigned long long) child->bytesReceived,
+            (unsigned long long) child->linesSent,
+            (unsigned long long) child->linesReceived);
+
+    ChildUsage usage = get_child_usage(child);
+    append_format(",\"max_rss_kb\":%lld,\"rss_kb\":%lld,\"threads\":%d,"
+            "\"samples\":%d,\"voluntary_switches\":%lld,"
+            "\"involuntary_switches\":%lld}", (long long) usage.maxResident,
+            (long long) usage.resident, usage.numThreads, usage.numSamples,
+            (long long) usage.voluntarySwitches,
+            (long long) usage.involuntarySwitches);
+}
+
+/*
+ * Prints an indented line of the given child's resource usage and I/O counts,
+ * following its status line in a text report.
+ */
+static void print_stats(Child* child) {
+    ChildTimes times = get_child_times(child);
+    ChildUsage usage = get_child_usage(child);
+    printf("    user %lld.%06llds, system %lld.%06llds, max rss %lld KiB, "
+            "rss %lld KiB, %lld/%lld context switches, sent %llu bytes "
+            "(%llu lines), received %llu bytes (%llu lines)\n",
+            (long long) times.userTime / MICROS_PER_SECOND,
+            (long long) times.userTime % MICROS_PER_SECOND,
+            (long long) times.systemTime / MICROS_PER_SECOND,
+            (long long) times.systemTime % MICROS_PER_SECOND,
+            (long long) usage.maxResident, (long long) usage.resident,
+            (long long) usage.voluntarySwitches,
+            (long long) usage.involuntarySwitches,
+            (unsigned long long) child->bytesSent,
+            (unsigned long long) child->linesSent,
+            (unsigned long long) child->bytesReceived,
+            (unsigned long long) child->linesReceived);
+}
+
+/*
+ * Adds the given child to the report buffer as a binary record.
+ */
+static void add_binary(Child* child) {
+    ChildStatus status = get_child_status(child);
+    ChildTimes times = get_child_times(child);
+    ChildUsage usage = get_child_usage(child);
+    const char* program = get_child_program(child);
+    size_t nameLength = strlen(program);
+    if (nameLength > UINT16_MAX) {
+        nameLength = UINT16_MAX;
+    }
+
+    size_t recordLength = BINARY_RECORD_FIXED_SIZE + nameLength;
+    char* out = reserve_report(sizeof(uint32_t) + recordLength);
+    out = put_le(out, recordLength, sizeof(uint32_t));
+    out = put_le(out, (uint32_t) child->jobId, sizeof(int32_t));
+    out = put_le(out, (uint32_t) get_child_pid(child), sizeof(int32_t));
+    out = put_le(out, status.state, sizeof(uint8_t));
+    out = put_le(out, status.value, sizeof(uint8_t));
+    out = put_le(out, nameLength, sizeof(uint16_t));
+    out = put_le(out, times.startTime, sizeof(int64_t));
+    out = put_le(out, times.endTime, sizeof(int64_t));
+    out = put_le(out, times.userTime, sizeof(int64_t));
+    out = put_le(out, times.systemTime, sizeof(int64_t));
+    out = put_le(out, child->bytesSent, sizeof(uint64_t));
+    out = put_le(out, child->bytesReceived, sizeof(uint64_t));
+    out = put_le(out, child->linesSent, sizeof(uint64_t));
+    out = put_le(out, child->linesReceived, sizeof(uint64_t));
+    out = put_le(out, usage.maxResident, sizeof(int64_t));
+    out = put_le(out, usage.resident, sizeof(int64_t));
+    out = put_le(out, usage.voluntarySwitches, sizeof(int64_t));
+    out = put_le(out, usage.involuntarySwitches, sizeof(int64_t));
+    out = put_le(out, (uint32_t) usage.numThreads, sizeof(int32_t));
+    out = put_le(out, (uint32_t) usage.numSamples, sizeof(int32_t));
+    memcpy(out, program, nameLength);
+    report.length = out + nameLength - report.data;
+}
+
+void add_to_report(Child* child) {
+    if (report.format == REPORT_TEXT) {
+        report_single_child(child);
+        if (report.showStats) {
+            print_stats(child);
+        }
+    } else if (report.format == REPORT_JSON) {
+        add_json(child);
+    } else {
+        add_binary(child);
+    }
+    report.numJobs++;
+}
+
+void finish_report() {
+    if (report.format == REPORT_TEXT) {
+        return;
+    } else if (report.format == REPORT_JSON) {
+        append_format("]}\n");
+    } else {
+        put_le(report.data, report.numJobs, sizeof(uint32_t));
+    }
+
+    // anything printed before the report must come out first
+    fflush(stdout);
+    size_t written = 0;
+    while (written < report.length) {
+        ssize_t numWritten = write(STDOUT_FILENO, report.data + written,
+                report.length - written);
+        if (numWritten < 0 && errno != EINTR) {
+            break;
+        } else if (numWritten > 0) {
+            written += numWritten;
+        }
+    }
+}
+
+void free_report_buffer() {
+    free(report.data);
+    report.data = NULL;
+    report.length = report.capacity = 0;
+}
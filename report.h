@@ -0,0 +1,71 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "child.h"
+
+#include <stdbool.h>
+
+/* Formats in which the report command can describe jobs. */
+typedef enum {
+    /* One "[Job] cmd:status" line per job, after a heading. */
+    REPORT_TEXT,
+    /* A single JSON object, {"jobs":[...]}, followed by a newline. Each job
+     * is an object with the fields "job", "pid", "program", "state"
+     * ("queued", "running", "exited" or "signalled"), "code" (if exited),
+     * "signal" (if signalled), "start_us", "end_us", "user_us",
+     * "system_us", "sent", "received", "lines_sent", "lines_received",
+     * "max_rss_kb", "rss_kb", "threads", "samples", "voluntary_switches" and
+     * "involuntary_switches", as described by Child, ChildTimes and
+     * ChildUsage. Times are in microseconds; start_us and end_us are since
+     * the epoch, and end_us is null while the job is running. A queued job's
+     * pid and start_us are 0. */
+    REPORT_JSON,
+    /* The number of jobs, followed by one length-prefixed record per job.
+     * Every integer is little-endian. Each record is:
+     *      u32 length of the rest of the record
+     *      i32 job ID          i32 process ID
+     *      u8  ChildState      u8  exit code or signal number
+     *      u16 length of the program name
+     *      i64 start time      i64 end time (0 while running)
+     *      i64 user CPU time   i64 system CPU time
+     *      u64 bytes sent      u64 bytes received
+     *      u64 lines sent      u64 lines received
+     *      i64 max RSS (KiB)   i64 RSS (KiB)
+     *      i64 voluntary context switches
+     *      i64 involuntary context switches
+     *      i32 threads         i32 samples
+     *      the program name, without a null terminator
+     * with times as in the JSON format. */
+    REPORT_BINARY
+} ReportFormat;
+
+/*
+ * Starts a report in the given format. Text reports are printed to standard
+ * output as they are made; JSON and binary reports are serialised into a
+ * single buffer, reused between reports, and written by finish_report().
+ *
+ * If showStats is set, a text report follows each job's status line with an
+ * indented line of the job's resource usage and I/O counts. JSON and binary
+ * reports always include them.
+ */
+void start_report(ReportFormat format, bool showStats);
+
+/*
+ * Adds the given child to the report started by start_report().
+ */
+void add_to_report(Child* child);
+
+/*
+ * Finishes the report started by start_report(). A JSON or binary report is
+ * written to standard output with a single write() after any output already
+ * buffered by stdio is flushed, so that reporting on any number of jobs costs
+ * one system call.
+ */
+void finish_report();
+
+/*
+ * Frees the buffer used to serialise reports.
+ */
+void free_report_buffer();
+
+#endif
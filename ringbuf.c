@@ -0,0 +1,100 @@
+#include "ringbuf.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+// number of bytes allocated when bytes are first queued
+#define RING_BUFFER_INITIAL_CAPACITY 4096
+
+void init_ring_buffer(RingBuffer* buffer) {
+    buffer->data = NULL;
+    buffer->capacity = 0;
+    buffer->head = 0;
+    buffer->length = 0;
+}
+
+/*
+ * Grows the given RingBuffer until it can hold at least the given number of
+ * bytes, moving the queued bytes to the start of the new storage.
+ */
+static void grow_ring_buffer(RingBuffer* buffer, size_t required) {
+    size_t capacity = buffer->capacity ? buffer->capacity
+            : RING_BUFFER_INITIAL_CAPACITY;
+    while (capacity < required) {
+        capacity *= 2;
+    }
+
+    char* data = malloc(capacity);
+    size_t firstPart = buffer->capacity - buffer->head;
+    if (!buffer->length) {
+        // nothing to move
+    } else if (buffer->length <= firstPart) {
+        memcpy(data, buffer->data + buffer->head, buffer->length);
+    } else { // queue wraps around the end of the old storage
+        memcpy(data, buffer->data + buffer->head, firstPart);
+        memcpy(data + firstPart, buffer->data, buffer->length - firstPart);
+    }
+
+    free(buffer->data);
+    buffer->data = data;
+    buffer->capacity = capacity;
+    buffer->head = 0;
+}
+
+void ring_buffer_append(RingBuffer* buffer, const char* bytes, size_t length) {
+    if (buffer->length + length > buffer->capacity) {
+        grow_ring_buffer(buffer, buffer->length + length);
+    }
+
+    // capacity is a power of two, so masking wraps offsets around the end
+    size_t mask = buffer->capacity - 1;
+    size_t tail = (buffer->head + buffer->length) & mask;
+    size_t firstPart = buffer->capacity - tail;
+    if (length <= firstPart) {
+        memcpy(buffer->data + tail, bytes, length);
+    } else {
+        memcpy(buffer->data + tail, bytes, firstPart);
+        memcpy(buffer->data, bytes + firstPart, length - firstPart);
+    }
+    buffer->length += length;
+}
+
+ssize_t ring_buffer_write(RingBuffer* buffer, int fd) {
+    if (!buffer->length) {
+        return 0;
+    }
+
+    struct iovec parts[2];
+    int numParts = 1;
+    size_t firstPart = buffer->capacity - buffer->head;
+    parts[0].iov_base = buffer->data + buffer->head;
+    if (buffer->length <= firstPart) {
+        parts[0].iov_len = buffer->length;
+    } else {
+        parts[0].iov_len = firstPart;
+        parts[1].iov_base = buffer->data;
+        parts[1].iov_len = buffer->length - firstPart;
+        numParts = 2;
+    }
+
+    ssize_t numWritten = writev(fd, parts, numParts);
+    if (numWritten > 0) {
+        buffer->head = (buffer->head + numWritten) & (buffer->capacity - 1);
+        buffer->length -= numWritten;
+        if (!buffer->length) {
+            buffer->head = 0;
+        }
+    }
+    return numWritten;
+}
+
+void ring_buffer_clear(RingBuffer* buffer) {
+    buffer->head = 0;
+    buffer->length = 0;
+}
+
+void free_ring_buffer(RingBuffer* buffer) {
+    free(buffer->data);
+    init_ring_buffer(buffer);
+}
@@ -0,0 +1,52 @@
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Stores bytes queued to be written to a file descriptor. */
+typedef struct {
+    /* Circular storage for the queued bytes. */
+    char* data;
+    /* Number of bytes allocated for data; zero or a power of two. */
+    size_t capacity;
+    /* Offset in data of the first queued byte. */
+    size_t head;
+    /* Number of bytes queued. */
+    size_t length;
+} RingBuffer;
+
+/*
+ * Initialises the given RingBuffer to be empty. No memory is allocated until
+ * bytes are first queued.
+ */
+void init_ring_buffer(RingBuffer* buffer);
+
+/*
+ * Queues the given bytes at the end of the given RingBuffer, growing it
+ * geometrically if there is not enough room.
+ */
+void ring_buffer_append(RingBuffer* buffer, const char* bytes, size_t length);
+
+/*
+ * Writes as many queued bytes as possible from the given RingBuffer to the
+ * given file descriptor with a single writev() call, which covers both parts
+ * of the queue if it wraps around the end of the storage. Written bytes are
+ * removed from the queue.
+ *
+ * Returns the number of bytes written, or -1 on error with errno set by
+ * writev().
+ */
+ssize_t ring_buffer_write(RingBuffer* buffer, int fd);
+
+/*
+ * Discards every byte queued in the given RingBuffer.
+ */
+void ring_buffer_clear(RingBuffer* buffer);
+
+/*
+ * Frees the memory held by the given RingBuffer, leaving it empty.
+ */
+void free_ring_buffer(RingBuffer* buffer);
+
+#endif
@@ -0,0 +1,149 @@
+#include "child.h"
+#include "sample.h"
+#include "settings.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// directory holding each process's statistics
+#define PROC_DIRECTORY "/proc"
+
+// size of the buffer each stat file is read into; comfortably larger than any
+// stat file
+#define STAT_BUFFER_SIZE 1024
+
+// longest path, relative to /proc, of a process's stat file
+#define STAT_PATH_SIZE 32
+
+// one-based positions, within a stat file, of the fields which are sampled
+#define STAT_FIRST_NUMERIC_FIELD 4
+#define STAT_USER_TIME_FIELD 14
+#define STAT_SYSTEM_TIME_FIELD 15
+#define STAT_NUM_THREADS_FIELD 20
+#define STAT_RESIDENT_FIELD 24
+
+// number of nanoseconds in a millisecond, and microseconds in a second
+#define NANOS_PER_MILLI 1000000LL
+#define MICROS_PER_SECOND 1000000LL
+
+/* Stores information about child processes created by the spawn command. */
+extern ChildList* childList;
+
+/* Descriptor for /proc, or -1 until the first sample. */
+static int procFd = -1;
+
+/* Time, from CLOCK_MONOTONIC, at which the next sample is due. */
+static struct timespec nextSample = {0, 0};
+
+/*
+ * Returns the number of milliseconds until the next sample is due, which is
+ * 0 if it is already due.
+ */
+static long long get_millis_until_sample() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long nanos = (nextSample.tv_sec - now.tv_sec) * 1000 * NANOS_PER_MILLI
+            + nextSample.tv_nsec - now.tv_nsec;
+    // round up, so the event loop doesn't wake just before the sample is due
+    return nanos > 0 ? (nanos + NANOS_PER_MILLI - 1) / NANOS_PER_MILLI : 0;
+}
+
+int get_sample_timeout(int timeout) {
+    if (!settings.sampleInterval || !childList->numRunning) {
+        return timeout;
+    }
+
+    long long untilSample = get_millis_until_sample();
+    return (timeout < 0 || untilSample < timeout) ? untilSample : timeout;
+}
+
+/*
+ * Parses the given contents of a process's stat file into the given slot of
+ * the global ChildList's times and usage.
+ */
+static void parse_stat(char* stat, int slot) {
+    // the command name may contain spaces and parentheses, so numeric fields
+    // are counted from the last parenthesis; field 3 is a single character
+    char* field = strrchr(stat, ')');
+    if (!field || strlen(field) < 4) {
+        return;
+    }
+    field += 4;
+
+    long long values[STAT_RESIDENT_FIELD + 1];
+    for (int i = STAT_FIRST_NUMERIC_FIELD; i <= STAT_RESIDENT_FIELD; i++) {
+        values[i] = strtoll(field, &field, 10);
+    }
+
+    long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    long pageKiB = sysconf(_SC_PAGESIZE) / 1024;
+    ChildTimes* times = &childList->times[slot];
+    times->userTime = values[STAT_USER_TIME_FIELD] * MICROS_PER_SECOND
+            / ticksPerSecond;
+    times->systemTime = values[STAT_SYSTEM_TIME_FIELD] * MICROS_PER_SECOND
+            / ticksPerSecond;
+
+    ChildUsage* usage = &childList->usage[slot];
+    usage->resident = values[STAT_RESIDENT_FIELD] * pageKiB;
+    if (usage->resident > usage->maxResident) {
+        usage->maxResident = usage->resident;
+    }
+    usage->numThreads = values[STAT_NUM_THREADS_FIELD];
+    usage->numSamples++;
+}
+
+/*
+ * Samples every running child in the global ChildList.
+ */
+static void sample_children() {
+    if (procFd < 0) {
+        procFd = open(PROC_DIRECTORY, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (procFd < 0) {
+            return;
+        }
+    }
+
+    char stat[STAT_BUFFER_SIZE];
+    char path[STAT_PATH_SIZE];
+    for (int slot = 0; slot < childList->numChildren; slot++) {
+        if (childList->statuses[slot].state != CHILD_RUNNING) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "%d/stat", childList->processIds[slot]);
+        int fd = openat(procFd, path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) { // exited, but not yet reaped
+            continue;
+        }
+        ssize_t numRead = read(fd, stat, sizeof(stat) - 1);
+        close(fd);
+        if (numRead > 0) {
+            stat[numRead] = '\0';
+            parse_stat(stat, slot);
+        }
+    }
+}
+
+void sample_children_if_due() {
+    if (!settings.sampleInterval || get_millis_until_sample()) {
+        return;
+    }
+
+    sample_children();
+    clock_gettime(CLOCK_MONOTONIC, &nextSample);
+    long long nanos = nextSample.tv_nsec
+            + settings.sampleInterval * NANOS_PER_MILLI;
+    nextSample.tv_sec += nanos / (1000 * NANOS_PER_MILLI);
+    nextSample.tv_nsec = nanos % (1000 * NANOS_PER_MILLI);
+}
+
+void free_sampler() {
+    if (procFd >= 0) {
+        close(procFd);
+        procFd = -1;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+/*
+ * Returns the given event loop timeout, in milliseconds (negative for no
+ * timeout), shortened if required so the event loop wakes in time for the
+ * next sample of running jobs. The timeout is unchanged if the samplems
+ * setting is 0 or no jobs are running.
+ */
+int get_sample_timeout(int timeout);
+
+/*
+ * Samples every running job's CPU time, resident set size and number of
+ * threads from /proc/<pid>/stat, if the samplems setting is non-zero and at
+ * least that many milliseconds have passed since the last sample.
+ *
+ * Every job is sampled in one pass, reading each stat file with a single
+ * read() into a shared buffer. Files are opened relative to a descriptor for
+ * /proc, held open between samples, so no path is resolved from the root.
+ */
+void sample_children_if_due();
+
+/*
+ * Closes the descriptor held for /proc, if any.
+ */
+void free_sampler();
+
+#endif
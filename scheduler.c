@@ -0,0 +1,252 @@
+#include "child.h"
+#include "event.h"
+#include "group.h"
+#include "launch.h"
+#include "scheduler.h"
+#include "settings.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// number of queues the queue list has room for before it first grows
+#define INITIAL_QUEUE_CAPACITY 4
+
+// number of jobs a queue has room for before it first grows
+#define INITIAL_QUEUED_JOB_CAPACITY 16
+
+/* Stores every named queue of jobs. */
+static JobQueue* queues = NULL;
+static int numQueues = 0;
+/* Number of queues the queues array has room for. */
+static int queueCapacity = 0;
+
+/* Number of jobs from any queue which have been started and not yet reaped. */
+static int numQueuedRunning = 0;
+
+/* Number of jobs waiting in any queue. */
+static int numWaiting = 0;
+
+/* Sequence number given to the next job queued. */
+static long long nextSequence = 0;
+
+int get_queue_id(char* name, bool create) {
+    for (int i = 0; i < numQueues; i++) {
+        if (!strcmp(queues[i].name, name)) {
+            return i;
+        }
+    }
+
+    if (!create) {
+        return -1;
+    }
+
+    if (numQueues == queueCapacity) {
+        queueCapacity = queueCapacity ? queueCapacity * 2
+                : INITIAL_QUEUE_CAPACITY;
+        queues = realloc(queues, sizeof(JobQueue) * queueCapacity);
+    }
+
+    JobQueue* queue = &queues[numQueues];
+    queue->name = strdup(name);
+    queue->limit = 0;
+    queue->numRunning = 0;
+    queue->jobs = NULL;
+    queue->numJobs = 0;
+    queue->capacity = 0;
+    return numQueues++;
+}
+
+JobQueue* get_queue(int queueId) {
+    return &queues[queueId];
+}
+
+/*
+ * Returns true if the first given job should be started before the second;
+ * false otherwise.
+ */
+static bool starts_before(QueuedJob* first, QueuedJob* second) {
+    if (first->priority != second->priority) {
+        return first->priority > second->priority;
+    }
+    return first->sequence < second->sequence;
+}
+
+/*
+ * Swaps the two given jobs.
+ */
+static void swap_jobs(QueuedJob* first, QueuedJob* second) {
+    QueuedJob temp = *first;
+    *first = *second;
+    *second = temp;
+}
+
+/*
+ * Returns a copy of the given NULL-terminated argument list, with the list
+ * and its strings in a single allocation which is freed with free().
+ */
+static char** copy_args(char** args) {
+    int numArgs = 0;
+    size_t length = 0;
+    while (args[numArgs]) {
+        length += strlen(args[numArgs++]) + 1;
+    }
+
+    char** copy = malloc(sizeof(char*) * (numArgs + 1) + length);
+    char* strings = (char*) (copy + numArgs + 1);
+    for (int i = 0; i < numArgs; i++) {
+        size_t size = strlen(args[i]) + 1;
+        copy[i] = memcpy(strings, args[i], size);
+        strings += size;
+    }
+    copy[numArgs] = NULL;
+    return copy;
+}
+
+/*
+ * Adds the given job to the given queue.
+ */
+static void push_job(JobQueue* queue, QueuedJob job) {
+    if (queue->numJobs == queue->capacity) {
+        queue->capacity = queue->capacity ? queue->capacity * 2
+                : INITIAL_QUEUED_JOB_CAPACITY;
+        queue->jobs = realloc(queue->jobs,
+                sizeof(QueuedJob) * queue->capacity);
+    }
+
+    // sift the new job up from the end of the heap
+    int i = queue->numJobs++;
+    queue->jobs[i] = job;
+    while (i && starts_before(&queue->jobs[i], &queue->jobs[(i - 1) / 2])) {
+        swap_jobs(&queue->jobs[i], &queue->jobs[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    numWaiting++;
+}
+
+void enqueue_job(int queueId, int priority, Child* child, char** args) {
+    push_job(get_queue(queueId), (QueuedJob) {priority, nextSequence++,
+            child->jobId, copy_args(args)});
+}
+
+/*
+ * Removes the job at the front of the given non-empty queue and returns it.
+ */
+static QueuedJob dequeue_job(JobQueue* queue) {
+    QueuedJob next = queue->jobs[0];
+    queue->jobs[0] = queue->jobs[--queue->numJobs];
+
+    // sift the moved job down from the root of the heap
+    int i = 0;
+    while (true) {
+        int first = i;
+        int left = i * 2 + 1;
+        int right = left + 1;
+        if (left < queue->numJobs
+                && starts_before(&queue->jobs[left], &queue->jobs[first])) {
+            first = left;
+        }
+        if (right < queue->numJobs
+                && starts_before(&queue->jobs[right], &queue->jobs[first])) {
+            first = right;
+        }
+        if (first == i) {
+            break;
+        }
+        swap_jobs(&queue->jobs[i], &queue->jobs[first]);
+        i = first;
+    }
+    numWaiting--;
+    return next;
+}
+
+/*
+ * Returns the queue whose front job should be started next, or NULL if no
+ * queue with waiting jobs is under its limit.
+ */
+static JobQueue* choose_queue() {
+    JobQueue* chosen = NULL;
+    for (int i = 0; i < numQueues; i++) {
+        JobQueue* queue = &queues[i];
+        if (queue->numJobs && (!queue->limit
+                || queue->numRunning < queue->limit) && (!chosen
+                || starts_before(&queue->jobs[0], &chosen->jobs[0]))) {
+            chosen = queue;
+        }
+    }
+    return chosen;
+}
+
+/*
+ * Starts the given job, dequeued from the given queue.
+ *
+ * Returns true if the job was started; false if its pipes or process could
+ * not be created.
+ */
+static bool start_queued_job(JobQueue* queue, QueuedJob* job) {
+    Child* child = get_child_by_jobid(job->jobId);
+    int pToC;
+    int cToP;
+    pid_t processId = launch_program(job->args,
+            get_process_group(get_child_group_id(child)), NULL,
+            &pToC, &cToP);
+    if (processId < 0) {
+        return false;
+    }
+
+    start_child(child, processId, pToC, cToP);
+    watch_child(child);
+    queue->numRunning++;
+    numQueuedRunning++;
+    return true;
+}
+
+void run_queued_jobs() {
+    while (!settings.maxConcurrency
+            || numQueuedRunning < settings.maxConcurrency) {
+        JobQueue* queue = choose_queue();
+        if (!queue) {
+            return;
+        }
+
+        // a job left queued might never be retried if nothing else is
+        // running, so one which cannot start fails as a bad exec would
+        QueuedJob job = dequeue_job(queue);
+        if (!start_queued_job(queue, &job)) {
+            fail_queued_child(get_child_by_jobid(job.jobId));
+        }
+        free(job.args);
+    }
+}
+
+void finish_queued_job(int queueId) {
+    get_queue(queueId)->numRunning--;
+    numQueuedRunning--;
+}
+
+void cancel_queued_jobs() {
+    for (int i = 0; i < numQueues; i++) {
+        JobQueue* queue = &queues[i];
+        for (int j = 0; j < queue->numJobs; j++) {
+            cancel_queued_child(get_child_by_jobid(queue->jobs[j].jobId));
+            free(queue->jobs[j].args);
+        }
+        numWaiting -= queue->numJobs;
+        queue->numJobs = 0;
+    }
+}
+
+int get_num_queued() {
+    return numWaiting;
+}
+
+void free_queues() {
+    for (int i = 0; i < numQueues; i++) {
+        for (int j = 0; j < queues[i].numJobs; j++) {
+            free(queues[i].jobs[j].args);
+        }
+        free(queues[i].jobs);
+        free(queues[i].name);
+    }
+    free(queues);
+}
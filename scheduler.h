@@ -0,0 +1,98 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "child.h"
+
+#include <stdbool.h>
+
+/* Name of the queue joined by jobs queued without a queue name. */
+#define DEFAULT_QUEUE_NAME "default"
+
+/* Stores a job waiting in a queue to be started. */
+typedef struct {
+    /* Priority of the job; higher priorities are started first. */
+    int priority;
+    /* Order in which the job was queued, so that jobs of equal priority are
+     * started first in, first out. */
+    long long sequence;
+    /* Job ID of the queued child. */
+    int jobId;
+    /* NULL-terminated arguments to run the job's program with, stored in a
+     * single allocation along with the strings they point to. */
+    char** args;
+} QueuedJob;
+
+/* Stores a named queue of jobs, started as capacity allows. */
+typedef struct {
+    /* Name of this queue, as given to the queue command. */
+    char* name;
+    /* Greatest number of this queue's jobs which may run at once; 0 places
+     * no limit other than the concurrency setting. */
+    int limit;
+    /* Number of this queue's jobs which have been started and not yet
+     * reaped. */
+    int numRunning;
+    /* Binary heap of the jobs waiting in this queue, with the next to start
+     * at the root. */
+    QueuedJob* jobs;
+    int numJobs;
+    /* Number of jobs the jobs array has room for. */
+    int capacity;
+} JobQueue;
+
+/*
+ * Returns the ID of the queue with the given name, creating the queue if
+ * create is set and it does not exist yet. Returns -1 if there is no such
+ * queue and create is not set.
+ */
+int get_queue_id(char* name, bool create);
+
+/*
+ * Returns a pointer to the queue with the given queue ID. The pointer is only
+ * valid until a queue is next created.
+ */
+JobQueue* get_queue(int queueId);
+
+/*
+ * Adds the given child, which must be in the CHILD_QUEUED state, to the queue
+ * with the given ID with the given priority. The child will run the program
+ * named by args[0] with the NULL-terminated argument list args, which is
+ * copied. The child is only started by run_queued_jobs().
+ */
+void enqueue_job(int queueId, int priority, Child* child, char** args);
+
+/*
+ * Starts queued jobs until the concurrency setting's number of queued jobs are
+ * running or no queue may start another. Each time, the job started is the
+ * one with the highest priority (first queued, among equals) at the front of
+ * any queue under its own limit, so a queue's idle share of capacity is taken
+ * up by the others. A job which cannot be started, because its pipes or
+ * process could not be created, is failed with fail_queued_child().
+ *
+ * Started jobs are watched by the event loop.
+ */
+void run_queued_jobs();
+
+/*
+ * Records that a started job from the queue with the given ID has been
+ * reaped. Jobs are started in its place by the next run_queued_jobs().
+ */
+void finish_queued_job(int queueId);
+
+/*
+ * Cancels every queued job with cancel_queued_child(), so that none is
+ * started.
+ */
+void cancel_queued_jobs();
+
+/*
+ * Returns the number of jobs waiting in queues.
+ */
+int get_num_queued();
+
+/*
+ * Frees every queue.
+ */
+void free_queues();
+
+#endif
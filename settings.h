@@ -0,0 +1,42 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdbool.h>
+
+/* Stores hq's settings, given on the command line or changed with the set
+ * command. */
+typedef struct {
+    /* Whether commands are run without prompts, and output is only flushed
+     * when its buffer fills or hq exits. */
+    bool batchMode;
+    /* Capacity, in bytes, requested for each new job's pipes with
+     * F_SETPIPE_SZ; 0 leaves the system default. */
+    int pipeSize;
+    /* Number of bytes which may be queued for a job by send before they are
+     * written without waiting for the event loop; 0 writes every send
+     * immediately. */
+    int highWaterMark;
+    /* Number of bytes of a job's output which may be buffered before hq stops
+     * reading from the job until rcv consumes some; 0 places no limit. */
+    int maxOutput;
+    /* Number of finished jobs kept for report and rcv before the oldest are
+     * evicted; 0 keeps every job. */
+    int retainJobs;
+    /* Number of seconds a finished job is kept before it is evicted; 0 keeps
+     * jobs indefinitely. */
+    int retainSeconds;
+    /* Whether each job is reported on as soon as it is reaped; non-zero
+     * turns this on. */
+    int watchStatus;
+    /* Number of milliseconds between samples of running jobs' CPU time and
+     * memory from /proc; 0 turns sampling off. */
+    int sampleInterval;
+    /* Number of jobs started by the queue command which may run at once; 0
+     * places no limit. */
+    int maxConcurrency;
+} Settings;
+
+/* Settings shared by all of hq. */
+extern Settings settings;
+
+#endif
@@ -1,52 +1,298 @@
+#include "linebuf.h"
 #include "sigcat.h"
 
-#include <csse2310a3.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
 #include <signal.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <sys/signalfd.h>
+#include <time.h>
+#include <unistd.h>
+
+/** Largest number of signals read from the signalfd at once. */
+#define MAX_SIGNALS_READ 64
+
+/** Longest signal notice written. */
+#define MAX_NOTICE_SIZE 160
+
+/** Indices of standard input and the signalfd in the polled descriptors. */
+#define POLL_INPUT 0
+#define POLL_SIGNALS 1
+
+/** Exit status when the command line is invalid. */
+#define EXIT_BAD_USAGE 1
+
+/** Number of milliseconds and nanoseconds in a second. */
+#define MS_PER_SECOND 1000
+#define NS_PER_MS 1000000
 
 /** Current output stream for the program. */
 FILE* outputStream;
 
-int main() {
-    char* input;
+/** Whether input is relayed in large blocks rather than line by line. */
+bool fastMode;
+
+/** Milliseconds between signal summaries; 0 reports every signal at once. */
+int summaryInterval;
+
+/** Whether the total count of each signal is printed on exit. */
+bool dumpCounts;
+
+/** Number of times each signal has been received in total, and since the
+ * last summary. */
+unsigned long totalCounts[NSIG];
+unsigned long pendingCounts[NSIG];
+
+/** Payload of the last sigqueue() of each signal since the last summary, and
+ * whether there was one. */
+int lastValues[NSIG];
+bool hasValues[NSIG];
+
+/** Signal (SIGUSR1 or SIGUSR2) whose stream switch awaits the next summary,
+ * or 0 if none does. */
+int pendingSwitch;
+
+/** Whether any signals are waiting for the next summary. */
+bool signalsPending;
+
+/** Time of the next signal summary, if any signals are pending. */
+struct timespec nextSummary;
+
+int main(int argc, char** argv) {
+    LineBuffer input;
+    init_line_buffer(&input);
     outputStream = stdout;
+    fastMode = !isatty(STDOUT_FILENO);
+    if (!parse_args(argc, argv)) {
+        fprintf(stderr,
+                "Usage: sigcat [--fast] [--interval <ms>] [--counts]\n");
+        return EXIT_BAD_USAGE;
+    }
 
-    set_handlers();
+    // signals are only ever handled here, between lines, never in a handler
+    struct pollfd polled[2];
+    polled[POLL_INPUT].fd = STDIN_FILENO;
+    polled[POLL_INPUT].events = POLLIN;
+    polled[POLL_SIGNALS].fd = set_handlers();
+    polled[POLL_SIGNALS].events = POLLIN;
 
-    do {
-        input = read_line(stdin);
-        if (input == NULL) {
-            break;
+    while (!input.eof) {
+        if (poll(polled, 2, get_poll_timeout()) < 0) {
+            continue; // interrupted
         }
-        fprintf(outputStream, "%s\n", input);
-        fflush(outputStream);
-        free(input);
-    } while (!feof(stdin));
 
+        if (polled[POLL_SIGNALS].revents) {
+            read_signals(polled[POLL_SIGNALS].fd);
+        }
+        if (polled[POLL_INPUT].revents) {
+            if (fill_line_buffer(&input, STDIN_FILENO) < 0 && errno != EINTR) {
+                break;
+            }
+            relay_lines(&input);
+        }
+        if (signalsPending && !get_poll_timeout()) {
+            report_pending_signals();
+        }
+    }
+
+    read_signals(polled[POLL_SIGNALS].fd);
+    report_pending_signals();
+    if (dumpCounts) {
+        report_totals();
+    }
+    free_line_buffer(&input);
     return 0;
 }
 
-void set_handlers() {
-    struct sigaction sa;
-    memset(&sa, 0, sizeof(sa));
-    sa.sa_handler = handler;
-    sa.sa_flags = SA_RESTART;
+bool parse_args(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--fast")) {
+            fastMode = true;
+        } else if (!strcmp(argv[i], "--counts")) {
+            dumpCounts = true;
+        } else if (!strcmp(argv[i], "--interval") && i + 1 < argc) {
+            if (!parse_interval(argv[++i], &summaryInterval)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_interval(const char* arg, int* interval) {
+    // strtol() would accept signs and leading spaces
+    if (!isdigit(arg[0])) {
+        return false;
+    }
+    char* end;
+    errno = 0;
+    long value = strtol(arg, &end, 10);
+    if (*end || errno || value > INT_MAX) {
+        return false;
+    }
+    *interval = value;
+    return true;
+}
 
+int set_handlers() {
+    sigset_t mask;
+    sigemptyset(&mask);
     for (int signum = 1; signum <= 31; signum++) {
-        sigaction(signum, &sa, 0);
+        sigaddset(&mask, signum);
+    }
+    for (int signum = SIGRTMIN; signum <= SIGRTMAX; signum++) {
+        sigaddset(&mask, signum);
     }
+
+    // SIGKILL and SIGSTOP are silently left unblocked, as they were
+    // previously left unhandled
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    return signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
 }
 
-void handler(int signum) {
-    fprintf(outputStream, "sigcat received %s\n", strsignal(signum));
-    fflush(outputStream);
+void relay_lines(LineBuffer* input) {
+    // in fast mode, every complete line read is written at once
+    if (fastMode) {
+        size_t length;
+        char* lines;
+        while ((lines = next_lines(input, &length))) {
+            write_fully(fileno(outputStream), lines, length);
+        }
+        return;
+    }
+
+    char* line;
+    while ((line = next_line(input))) {
+        fprintf(outputStream, "%s\n", line);
+        fflush(outputStream);
+    }
+}
 
-    if (signum == 10) {
+void read_signals(int signalFd) {
+    struct signalfd_siginfo info[MAX_SIGNALS_READ];
+    ssize_t numRead;
+    while ((numRead = read(signalFd, info, sizeof(info))) > 0) {
+        for (int i = 0; i < numRead / sizeof(info[0]); i++) {
+            record_signal(&info[i]);
+        }
+    }
+}
+
+void record_signal(struct signalfd_siginfo* info) {
+    int signum = info->ssi_signo;
+    bool hasValue = info->ssi_code == SI_QUEUE;
+    totalCounts[signum]++;
+
+    if (!summaryInterval) {
+        report_signal(signum, 1, info->ssi_int, hasValue);
+        switch_stream(signum);
+        return;
+    }
+
+    // the first pending signal starts the countdown to the next summary
+    if (!signalsPending) {
+        signalsPending = true;
+        clock_gettime(CLOCK_MONOTONIC, &nextSummary);
+        nextSummary.tv_sec += summaryInterval / MS_PER_SECOND;
+        nextSummary.tv_nsec += (summaryInterval % MS_PER_SECOND) * NS_PER_MS;
+        if (nextSummary.tv_nsec >= MS_PER_SECOND * NS_PER_MS) {
+            nextSummary.tv_sec++;
+            nextSummary.tv_nsec -= MS_PER_SECOND * NS_PER_MS;
+        }
+    }
+
+    pendingCounts[signum]++;
+    if (hasValue) {
+        lastValues[signum] = info->ssi_int;
+        hasValues[signum] = true;
+    }
+    if (signum == SIGUSR1 || signum == SIGUSR2) {
+        pendingSwitch = signum;
+    }
+}
+
+int get_poll_timeout() {
+    if (!signalsPending) {
+        return -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long remaining = (nextSummary.tv_sec - now.tv_sec) * MS_PER_SECOND
+            + (nextSummary.tv_nsec - now.tv_nsec) / NS_PER_MS;
+    return remaining > 0 ? remaining : 0;
+}
+
+void report_pending_signals() {
+    signalsPending = false;
+    for (int signum = 1; signum < NSIG; signum++) {
+        if (pendingCounts[signum]) {
+            report_signal(signum, pendingCounts[signum], lastValues[signum],
+                    hasValues[signum]);
+            pendingCounts[signum] = 0;
+            hasValues[signum] = false;
+        }
+    }
+
+    if (pendingSwitch) {
+        switch_stream(pendingSwitch);
+        pendingSwitch = 0;
+    }
+}
+
+void report_signal(int signum, unsigned long count, int value,
+        bool hasValue) {
+    // each notice is written with a single write(), so it is never split
+    char notice[MAX_NOTICE_SIZE];
+    int length = snprintf(notice, sizeof(notice), "sigcat received %s",
+            strsignal(signum));
+    if (count > 1) {
+        length += snprintf(notice + length, sizeof(notice) - length, " x%lu",
+                count);
+    }
+    if (hasValue) {
+        length += snprintf(notice + length, sizeof(notice) - length,
+                count > 1 ? " (last value %d)" : " (value %d)", value);
+    }
+    notice[length++] = '\n';
+    write_fully(fileno(outputStream), notice, length);
+}
+
+void report_totals() {
+    char notice[MAX_NOTICE_SIZE];
+    for (int signum = 1; signum < NSIG; signum++) {
+        if (totalCounts[signum]) {
+            int length = snprintf(notice, sizeof(notice),
+                    "sigcat total %s x%lu\n", strsignal(signum),
+                    totalCounts[signum]);
+            write_fully(fileno(outputStream), notice, length);
+        }
+    }
+}
+
+void switch_stream(int signum) {
+    if (signum == SIGUSR1) {
         outputStream = stdout;
-    } else if (signum == 12) {
+    } else if (signum == SIGUSR2) {
         outputStream = stderr;
     }
 }
 
+void write_fully(int fd, const char* bytes, size_t length) {
+    while (length) {
+        ssize_t numWritten = write(fd, bytes, length);
+        if (numWritten < 0 && errno != EINTR) {
+            return;
+        } else if (numWritten > 0) {
+            bytes += numWritten;
+            length -= numWritten;
+        }
+    }
+}
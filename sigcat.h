@@ -1,13 +1,99 @@
+#include "linebuf.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/signalfd.h>
+
+/**
+ * Sets the program's options from its command line arguments:
+ *     sigcat [--fast] [--interval <ms>] [--counts]
+ * --fast relays input in large blocks even when standard output is a
+ * terminal. --interval batches signal notices into one summary per signal
+ * every ms milliseconds. --counts prints the total count of each signal on
+ * exit.
+ *
+ * Returns true if the arguments are valid; false if any argument is unknown
+ * or the interval is missing or not a non-negative integer.
+ */
+bool parse_args(int argc, char** argv);
+
+/**
+ * Parses the given string, which must consist only of decimal digits, as a
+ * non-negative number of milliseconds no greater than INT_MAX, storing it in
+ * interval.
+ *
+ * Returns true if the string is valid; false otherwise.
+ */
+bool parse_interval(const char* arg, int* interval);
+
 /**
- * Sets the handler for all signals (1 to 31) to the handler method.
+ * Blocks all signals (1 to 31, and the real-time signals) so that they are
+ * delivered through a signalfd instead of interrupting the program. Signals
+ * are then reported by the main loop, between lines of output, rather than in
+ * signal context.
+ *
+ * Returns the non-blocking signalfd the signals are delivered to.
  */
-void set_handlers();
+int set_handlers();
+
+/**
+ * Writes every complete line in the given buffer to the current output
+ * stream: one line at a time, or all at once with a single write() in fast
+ * mode.
+ */
+void relay_lines(LineBuffer* input);
+
+/**
+ * Reads every signal waiting on the given signalfd and records each with
+ * record_signal(), in the order they arrived.
+ */
+void read_signals(int signalFd);
+
+/**
+ * Counts the given received signal. If there is no summary interval, the
+ * signal is reported immediately; otherwise, it is reported in the next
+ * summary.
+ */
+void record_signal(struct signalfd_siginfo* info);
+
+/**
+ * Returns the number of milliseconds until the next signal summary is due, 0
+ * if it is overdue, or -1 if no signals are waiting to be summarised.
+ */
+int get_poll_timeout();
+
+/**
+ * Reports every signal received since the last summary, once per signal with
+ * its count, and applies the last stream switch requested since then.
+ */
+void report_pending_signals();
 
 /**
  * Print the following text:
  *     sigcat received <signal name>
  * to the current output stream, where <signal name> is replaced by
- * the signal name reported by strsignal().
+ * the signal name reported by strsignal(). If count is more than 1, " x"
+ * followed by count is added. If hasValue is set, the sigqueue() payload
+ * value is added in parentheses. The text is written with a single write()
+ * call, so it cannot be interleaved with other output.
  */
-void handler(int signum);
+void report_signal(int signum, unsigned long count, int value, bool hasValue);
 
+/**
+ * Prints the total number of times each signal was received, as
+ *     sigcat total <signal name> x<count>
+ * for each signal received at least once.
+ */
+void report_totals();
+
+/**
+ * Changes the current output stream to standard output if the given signal
+ * is SIGUSR1, or to standard error if it is SIGUSR2.
+ */
+void switch_stream(int signum);
+
+/**
+ * Writes all of the given bytes to the given file descriptor, continuing
+ * after partial writes and interruptions by signals.
+ */
+void write_fully(int fd, const char* bytes, size_t length);
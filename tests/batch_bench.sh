@@ -0,0 +1,37 @@
+#!/bin/sh
+# Measures how many commands per second hq runs from a script:
+# - interactively, with the script on standard input, so that a prompt is
+#   printed and the output flushed for every command;
+# - with --batch and the script on standard input; and
+# - with -f, reading the script from the file itself.
+# Each script reports one job, and sends it a line, over and over.
+#
+# Usage: tests/batch_bench.sh [<numcommands>]    (run after make; 100000
+#        commands by default)
+
+NUM_COMMANDS=${1:-100000}
+
+cd "$(dirname "$0")/.." || exit 1
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+awk -v numCommands="$NUM_COMMANDS" 'BEGIN {
+    print "spawn cat"
+    for (i = 1; i < numCommands; i += 2) {
+        print "report 0"
+        print "send 0 hello"
+    }
+}' > "$dir/script"
+
+# prints the commands per second of the given hq command, which writes its
+# output to a file
+measure() {
+    start=$(date +%s%N)
+    "$@" > "$dir/output"
+    echo "$((NUM_COMMANDS * 1000 / (($(date +%s%N) - start) / 1000000)))" \
+            "commands/s"
+}
+
+echo "interactive: $(measure ./hq < "$dir/script")"
+echo "--batch: $(measure ./hq --batch < "$dir/script")"
+echo "-f: $(measure ./hq -f "$dir/script")"
@@ -0,0 +1,47 @@
+#!/bin/sh
+# Checks that a job can still join its group after the group's process group
+# has emptied: the leader has been reaped and the only other member has left
+# with setsid. The job must run (not be reported as a failed exec) and lead
+# the group's new process group, so a group signal still reaches it. Both
+# the posix_spawnp() path and the fork() path (taken with --nice) are run.
+#
+# Usage: tests/groups.sh    (run after make)
+
+cd "$(dirname "$0")/.." || exit 1
+
+output=$(./hq --batch <<'COMMANDS'
+spawn sleep 10
+spawn setsid sleep 10
+signal 0 9
+sleep 0.2
+spawn echo hi
+spawn sleep 10
+sleep 0.2
+signal default 9
+sleep 0.2
+spawn --group limited sleep 10
+spawn --group limited setsid sleep 10
+signal 4 9
+sleep 0.2
+spawn --group limited --nice 1 echo hi
+spawn --group limited --nice 1 sleep 10
+sleep 0.2
+signal limited 9
+sleep 0.2
+report
+COMMANDS
+)
+
+status=0
+for expected in "[2] echo:exited(0)" "[3] sleep:signalled(9)" \
+        "[6] echo:exited(0)" "[7] sleep:signalled(9)"; do
+    if ! printf '%s\n' "$output" | grep -qxF "$expected"; then
+        echo "FAIL: expected $expected"
+        status=1
+    fi
+done
+if [ "$status" -ne 0 ]; then
+    printf '%s\n' "$output"
+    exit 1
+fi
+echo "PASS: jobs lead their groups' new process groups"
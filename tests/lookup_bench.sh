@@ -0,0 +1,38 @@
+#!/bin/sh
+# Measures the cost of finding a job by its ID with 10, 1000 and 100000 jobs
+# in hq's job table. The jobs are queued behind a concurrency limit of one,
+# so only one process runs. Each lookup is a report of a randomly chosen
+# job; the time taken to build the table alone is subtracted.
+#
+# Usage: tests/lookup_bench.sh [<numlookups>]    (run after make; 100000
+#        lookups by default)
+
+NUM_LOOKUPS=${1:-100000}
+
+cd "$(dirname "$0")/.." || exit 1
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+# prints the number of milliseconds taken to run the given hq script
+run_script() {
+    start=$(date +%s%N)
+    ./hq -f "$1" > /dev/null
+    echo $((($(date +%s%N) - start) / 1000000))
+}
+
+for numJobs in 10 1000 100000; do
+    printf 'set concurrency 1\nqueue -n %d sleep 100\n' "$numJobs" \
+            > "$dir/setup"
+    cp "$dir/setup" "$dir/lookups"
+    awk -v numJobs="$numJobs" -v numLookups="$NUM_LOOKUPS" 'BEGIN {
+        srand(1)
+        for (i = 0; i < numLookups; i++) {
+            printf "report %d\n", int(rand() * numJobs)
+        }
+    }' >> "$dir/lookups"
+
+    setupTime=$(run_script "$dir/setup")
+    totalTime=$(run_script "$dir/lookups")
+    echo "$numJobs jobs: $(((totalTime - setupTime) * 1000000 / NUM_LOOKUPS))" \
+            "ns per lookup and report"
+done
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Measures the cost of parsing and running a command in hq over a mix of
+# commands against one sleeping job: reports, sends of quoted text, signals,
+# rcvs, zero-length waits, settings and unknown commands. The time taken to
+# start hq and the job alone is subtracted. Another hq binary may be given
+# to compare against, e.g. one built from an earlier commit.
+#
+# Usage: tests/parse_bench.sh [<numcommands> [<hq>...]]    (run after make;
+#        one million commands and ./hq by default)
+
+NUM_COMMANDS=${1:-1000000}
+[ $# -gt 0 ] && shift
+[ $# -eq 0 ] && set -- ./hq
+
+cd "$(dirname "$0")/.." || exit 1
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+echo "spawn sleep 1000" > "$dir/setup"
+awk -v numCommands="$NUM_COMMANDS" 'BEGIN {
+    split("report 0|send 0 \"some quoted text\"|signal 0 0|rcv 0|wait 0 0|" \
+            "set hwm 65536|bogus 1 2 3", commands, "|")
+    print "spawn sleep 1000"
+    for (i = 0; i < numCommands; i++) {
+        print commands[i % 7 + 1]
+    }
+}' > "$dir/commands"
+
+# prints the number of milliseconds taken by the given hq to run the given
+# script
+run_script() {
+    start=$(date +%s%N)
+    "$1" -f "$2" > /dev/null
+    echo $((($(date +%s%N) - start) / 1000000))
+}
+
+for hq; do
+    setupTime=$(run_script "$hq" "$dir/setup")
+    totalTime=$(run_script "$hq" "$dir/commands")
+    echo "$hq: $(((totalTime - setupTime) * 1000000 / NUM_COMMANDS))" \
+            "ns per command"
+done
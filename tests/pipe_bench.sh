@@ -0,0 +1,68 @@
+#!/bin/sh
+# Compares the throughput of moving a job's output into another job with the
+# pipe command against relaying it through hq with rcv and send. The relay
+# is timed in two parts: one script receives every line of the source job,
+# and another sends each of them to the target job with its own send
+# command (the commands are generated between the two, untimed).
+#
+# Usage: tests/pipe_bench.sh [<pipemib> [<relaymib>]]    (run after make;
+#        256 MiB are piped and 16 MiB relayed by default)
+
+PIPE_MIB=${1:-256}
+RELAY_MIB=${2:-16}
+
+cd "$(dirname "$0")/.." || exit 1
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+# prints the number of milliseconds taken to run the given hq script, whose
+# output is written to the given file
+run_script() {
+    start=$(date +%s%N)
+    ./hq -f "$1" > "$2"
+    echo $((($(date +%s%N) - start) / 1000000))
+}
+
+# writes the given number of MiB of 64-byte lines to the given file
+make_data() {
+    yes "$(printf '%063d' 0 | tr 0 x)" | head -c $(($1 * 1024 * 1024)) > "$2"
+}
+
+# checks that the given output of wc -c matches the given number of MiB
+check_count() {
+    if [ "$(tail -n 1 "$1")" -ne $(($2 * 1024 * 1024)) ]; then
+        echo "FAIL: $(tail -n 1 "$1") bytes arrived"
+        exit 1
+    fi
+}
+
+make_data "$PIPE_MIB" "$dir/data"
+cat > "$dir/pipe" <<COMMANDS
+spawn cat $dir/data
+spawn wc -c
+pipe 0 1
+wait 1
+rcv 1
+COMMANDS
+pipeTime=$(run_script "$dir/pipe" "$dir/piped")
+check_count "$dir/piped" "$PIPE_MIB"
+echo "pipe: $((PIPE_MIB * 1000 / pipeTime)) MiB/s"
+
+make_data "$RELAY_MIB" "$dir/data"
+cat > "$dir/receive" <<COMMANDS
+set maxoutput 0
+spawn cat $dir/data
+wait 0
+rcv 0 all
+COMMANDS
+receiveTime=$(run_script "$dir/receive" "$dir/received")
+{
+    echo "spawn wc -c"
+    grep -v "^New Job\|^<EOF>" "$dir/received" | sed "s/^/send 0 /"
+    echo "eof 0"
+    echo "wait 0"
+    echo "rcv 0"
+} > "$dir/send"
+sendTime=$(run_script "$dir/send" "$dir/sent")
+check_count "$dir/sent" "$RELAY_MIB"
+echo "rcv and send: $((RELAY_MIB * 1000 / (receiveTime + sendTime))) MiB/s"
@@ -0,0 +1,52 @@
+#!/bin/sh
+# Measures the scheduling overhead per job of the queue command with 50000
+# jobs of true, at concurrency limits of 1 and 8. The same jobs are also run
+# without the scheduler, each spawned only once the one before has been
+# waited for; the difference per job is the overhead.
+#
+# Usage: tests/queue_bench.sh [<numjobs>]    (run after make; 50000 jobs by
+#        default)
+
+NUM_JOBS=${1:-50000}
+
+cd "$(dirname "$0")/.." || exit 1
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+# prints the number of microseconds per job taken to run the given hq
+# script, which ends with a report, failing if any job did not exit
+# successfully
+run_script() {
+    start=$(date +%s%N)
+    ./hq -f "$1" > "$dir/output"
+    elapsed=$((($(date +%s%N) - start) / 1000))
+    if [ "$(grep -c ":exited(0)$" "$dir/output")" -ne "$NUM_JOBS" ]; then
+        echo "FAIL: not every job exited successfully" >&2
+        exit 1
+    fi
+    echo $((elapsed / NUM_JOBS))
+}
+
+awk -v numJobs="$NUM_JOBS" 'BEGIN {
+    for (i = 0; i < numJobs; i++) {
+        printf "spawn true\nwait %d\n", i
+    }
+    print "report"
+}' > "$dir/spawn"
+spawnTime=$(run_script "$dir/spawn") || exit 1
+echo "spawn and wait: $spawnTime us per job"
+
+for concurrency in 1 8; do
+    # the last jobs may finish in any order, so each is waited for
+    awk -v numJobs="$NUM_JOBS" -v concurrency="$concurrency" 'BEGIN {
+        printf "set concurrency %d\nqueue -n %d true\n", concurrency,
+                numJobs
+        for (i = numJobs - concurrency; i < numJobs; i++) {
+            printf "wait %d\n", i
+        }
+        print "report"
+    }' > "$dir/queue"
+    queueTime=$(run_script "$dir/queue") || exit 1
+    echo "queue at concurrency $concurrency: $queueTime us per job" \
+            "($((queueTime - spawnTime)) us overhead)"
+done
@@ -0,0 +1,68 @@
+#!/bin/sh
+# Measures hq's resident memory and the time taken by report once 100000
+# jobs have finished. The jobs are spawned 5000 at a time, each batch
+# reaped before the next, so that hq stays within its descriptor limit. hq
+# is driven through a FIFO, and ten reports are timed together.
+#
+# Usage: tests/report_bench.sh [<numbatches> [<hq>]]    (run after make; 20
+#        batches and ./hq by default)
+
+NUM_BATCHES=${1:-20}
+HQ=${2:-./hq}
+BATCH_SIZE=5000
+NUM_REPORTS=10
+
+cd "$(dirname "$0")/.." || exit 1
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+mkfifo "$dir/commands"
+
+# waits until hq has printed the given number of report --fds readouts
+await_readouts() {
+    until [ "$(grep -c "^Jobs:" "$dir/output")" -ge "$1" ]; do
+        sleep 0.01
+    done
+}
+
+# prints the given field of hq's /proc status, in KiB
+memory() {
+    awk -v field="$1:" '$1 == field { print $2 }' "/proc/$hq/status"
+}
+
+"$HQ" < "$dir/commands" > "$dir/output" &
+hq=$!
+exec 3> "$dir/commands"
+echo "report --fds" >&3
+await_readouts 1
+startRss=$(memory VmRSS)
+
+i=0
+while [ "$i" -lt "$NUM_BATCHES" ]; do
+    echo "spawn -n $BATCH_SIZE true" >&3
+    echo "wait $(((i + 1) * BATCH_SIZE - 1))" >&3
+    i=$((i + 1))
+done
+echo "sleep 0.5" >&3
+echo "report --fds" >&3
+await_readouts 2
+rss=$(memory VmRSS)
+
+start=$(date +%s%N)
+i=0
+while [ "$i" -lt "$NUM_REPORTS" ]; do
+    echo "report" >&3
+    i=$((i + 1))
+done
+echo "report --fds" >&3
+await_readouts 3
+elapsed=$((($(date +%s%N) - start) / 1000))
+
+exec 3>&-
+wait "$hq"
+if grep -q "Error:" "$dir/output"; then
+    echo "FAIL: not every job was created"
+    exit 1
+fi
+echo "$((NUM_BATCHES * BATCH_SIZE)) jobs:"
+echo "    RSS: $startRss KiB at startup, $rss KiB with the jobs"
+echo "    report: $((elapsed / NUM_REPORTS / 1000)) ms"
@@ -0,0 +1,54 @@
+#!/bin/sh
+# Measures the throughput of the line scanning shared by sigcat and hq, on
+# inputs of short (16-byte) and long (4 KiB) lines:
+# - sigcat relaying its input in blocks of whole lines, as it does when its
+#   output is not a terminal; and
+# - hq splitting a job's output into lines for rcv, which prints each one.
+# cat's throughput on the same input is given as a ceiling.
+#
+# Usage: tests/scan_bench.sh [<mib>]    (run after make; 256 MiB inputs by
+#        default)
+
+MIB=${1:-256}
+
+cd "$(dirname "$0")/.." || exit 1
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+# prints the throughput, in MiB/s, of the given command on the input file
+measure() {
+    start=$(date +%s%N)
+    "$@" < "$dir/input" > /dev/null
+    echo "$((MIB * 1000 / (($(date +%s%N) - start) / 1000000))) MiB/s"
+}
+
+for lineLength in 16 4096; do
+    yes "$(printf "%0$((lineLength - 1))d" 0 | tr 0 x)" \
+            | head -c $((MIB * 1024 * 1024)) > "$dir/input"
+    numLines=$((MIB * 1024 * 1024 / lineLength))
+
+    # rcv only reads what is already in the job's pipe, so it is repeated
+    # until the output ends; each repeat gets at least one pipe read, so one
+    # per 4 KiB of input is plenty
+    {
+        echo "spawn cat $dir/input"
+        i=0
+        while [ "$i" -le $((MIB * 256)) ]; do
+            echo "waitoutput 0"
+            echo "rcv 0 all"
+            i=$((i + 1))
+        done
+    } > "$dir/script"
+
+    # the script must drain the job, or hq's figure would be meaningless
+    ./hq -f "$dir/script" < /dev/null > "$dir/output"
+    if [ "$(grep -c '^x' "$dir/output")" -ne "$numLines" ]; then
+        echo "FAIL: rcv did not receive every line"
+        exit 1
+    fi
+
+    echo "$lineLength-byte lines:"
+    echo "    cat: $(measure cat)"
+    echo "    sigcat: $(measure ./sigcat)"
+    echo "    hq rcv: $(measure ./hq -f "$dir/script")"
+done
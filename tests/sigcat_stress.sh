@@ -0,0 +1,68 @@
+#!/bin/sh
+# Streams numbered lines through sigcat while signalling it repeatedly, then
+# checks that every line arrived intact and in order, and that every signal
+# notice starts at a line boundary rather than splitting a line.
+#
+# Usage: tests/sigcat_stress.sh [<numsignals>]    (run after make; 100000
+#        signals by default)
+
+NUM_SIGNALS=${1:-100000}
+BATCH=1000
+
+cd "$(dirname "$0")/.." || exit 1
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+# lines are written in paced batches until the signals have all been sent,
+# so data is still flowing as each signal arrives
+produce() {
+    numLines=0
+    while [ ! -e "$dir/done" ]; do
+        seq $((numLines + 1)) $((numLines + BATCH))
+        numLines=$((numLines + BATCH))
+        sleep 0.005
+    done
+    echo "$numLines" > "$dir/lines"
+}
+
+produce | ./sigcat > "$dir/output" &
+sigcat=$!
+sleep 0.1
+
+# SIGUSR1 and SIGUSR2 would switch sigcat's output stream, so are not sent
+i=0
+while [ "$i" -lt "$NUM_SIGNALS" ]; do
+    case $((i % 3)) in
+        0) kill -HUP "$sigcat" ;;
+        1) kill -TERM "$sigcat" ;;
+        2) kill -WINCH "$sigcat" ;;
+    esac || break
+    i=$((i + 1))
+done
+touch "$dir/done"
+wait "$sigcat"
+
+if [ "$i" -ne "$NUM_SIGNALS" ]; then
+    echo "FAIL: sigcat exited after $i signals"
+    exit 1
+fi
+
+# every line must be the next number or a whole notice; standard signals
+# sent while one is pending are merged, so there may be fewer notices than
+# signals sent
+awk -v expected="$(cat "$dir/lines")" '
+    /^[0-9]+$/ && $0 == next_line + 1 { next_line++; next }
+    /^sigcat received [A-Za-z ]+( x[0-9]+)?$/ { notices++; next }
+    { print "FAIL: bad line " NR ": " $0; bad = 1; exit }
+    END {
+        if (bad) {
+            exit 1
+        } else if (next_line != expected) {
+            print "FAIL: " next_line " of " expected " lines relayed"
+            exit 1
+        } else if (!notices) {
+            print "FAIL: no signal notices"
+            exit 1
+        }
+        print "PASS: " expected " lines intact around " notices " notices"
+    }' "$dir/output"
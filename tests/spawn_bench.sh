@@ -0,0 +1,51 @@
+#!/bin/sh
+# Measures how many jobs hq spawns per second with 0, 1000 and 10000 jobs
+# already in its job table. Each measured job is started by its own spawn
+# command. hq is driven through a FIFO, and only the spawns are timed, from
+# once the existing jobs have all been reaped.
+#
+# Usage: tests/spawn_bench.sh [<numspawns>]    (run after make; 1000 spawns
+#        by default)
+
+NUM_SPAWNS=${1:-1000}
+
+cd "$(dirname "$0")/.." || exit 1
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+mkfifo "$dir/commands"
+
+# waits until hq has printed the given number of report --fds readouts
+await_readouts() {
+    until [ "$(grep -c "^Jobs:" "$dir/output")" -ge "$1" ]; do
+        sleep 0.01
+    done
+}
+
+for numExisting in 0 1000 10000; do
+    ./hq < "$dir/commands" > "$dir/output" &
+    hq=$!
+    exec 3> "$dir/commands"
+
+    if [ "$numExisting" -gt 0 ]; then
+        echo "spawn -n $numExisting true" >&3
+        echo "wait $((numExisting - 1))" >&3
+        echo "sleep 0.5" >&3
+    fi
+    echo "report --fds" >&3
+    await_readouts 1
+
+    start=$(date +%s%N)
+    i=0
+    while [ "$i" -lt "$NUM_SPAWNS" ]; do
+        echo "spawn true"
+        i=$((i + 1))
+    done >&3
+    echo "report --fds" >&3
+    await_readouts 2
+    elapsed=$((($(date +%s%N) - start) / 1000000))
+
+    exec 3>&-
+    wait "$hq"
+    echo "$numExisting existing jobs:" \
+            "$((NUM_SPAWNS * 1000 / elapsed)) spawns per second"
+done
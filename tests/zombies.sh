@@ -0,0 +1,61 @@
+#!/bin/sh
+# Spawns and kills many short-lived jobs through hq, then checks that every
+# one of them has been reaped: none is left a zombie and none is still
+# reported as running.
+#
+# Usage: tests/zombies.sh [<numjobs>]    (run after make; 5000 jobs by default)
+
+NUM_JOBS=${1:-5000}
+BATCH=100
+
+cd "$(dirname "$0")/.." || exit 1
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+mkfifo "$dir/commands"
+
+./hq < "$dir/commands" > "$dir/output" &
+hq=$!
+exec 3> "$dir/commands"
+
+# half of each batch is killed while running and half exits by itself
+awk -v numJobs="$NUM_JOBS" -v batch="$BATCH" 'BEGIN {
+    for (first = 0; first < numJobs; first += batch) {
+        for (i = first; i < first + batch; i++) {
+            print (i % 2) ? "spawn true" : "spawn sleep 10"
+        }
+        for (i = first; i < first + batch; i++) {
+            printf "signal %d 9\n", i
+        }
+    }
+    print "sleep 2"
+    print "report"
+}' >&3
+
+# hq is left running, with its jobs' statuses unread, until it is checked
+tries=0
+until [ "$(grep -c "^\[[0-9]*\] " "$dir/output")" -ge "$NUM_JOBS" ]; do
+    tries=$((tries + 1))
+    if [ "$tries" -gt 600 ] || ! kill -0 "$hq" 2> /dev/null; then
+        echo "FAIL: hq did not finish running the jobs"
+        exit 1
+    fi
+    sleep 0.1
+done
+
+status=0
+zombies=$(ps -o pid=,stat= --ppid "$hq" | awk '$2 ~ /^Z/' | wc -l)
+if [ "$zombies" -ne 0 ]; then
+    echo "FAIL: $zombies zombie jobs"
+    status=1
+fi
+reported=$(grep -c "^\[[0-9]*\] " "$dir/output")
+running=$(grep -c ":running$" "$dir/output")
+if [ "$reported" -ne "$NUM_JOBS" ] || [ "$running" -ne 0 ]; then
+    echo "FAIL: $reported jobs reported, $running still running"
+    status=1
+fi
+
+exec 3>&-
+wait "$hq"
+[ "$status" -eq 0 ] && echo "PASS: $NUM_JOBS jobs reaped"
+exit "$status"
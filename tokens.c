@@ -0,0 +1,72 @@
+#include "tokens.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+// number of token pointers allocated when a line is first split
+#define TOKEN_LIST_INITIAL_CAPACITY 16
+
+void init_token_list(TokenList* list) {
+    list->tokens = NULL;
+    list->numTokens = 0;
+    list->capacity = 0;
+}
+
+/*
+ * Ensures the given TokenList has room for at least the given number of
+ * pointers, doubling its capacity as many times as required.
+ */
+static void reserve_tokens(TokenList* list, int capacity) {
+    if (capacity <= list->capacity) {
+        return;
+    }
+
+    int newCapacity = list->capacity ? list->capacity
+            : TOKEN_LIST_INITIAL_CAPACITY;
+    while (newCapacity < capacity) {
+        newCapacity *= 2;
+    }
+    list->tokens = realloc(list->tokens, newCapacity * sizeof(char*));
+    list->capacity = newCapacity;
+}
+
+int split_tokens(TokenList* list, char* line) {
+    list->numTokens = 0;
+    char* read = line;
+    while (*read) {
+        while (*read == ' ') {
+            read++;
+        }
+        if (!*read) {
+            break;
+        }
+
+        // quotes are dropped by copying each token over itself, so the write
+        // position never passes the read position
+        char* write = read;
+        reserve_tokens(list, list->numTokens + 1);
+        list->tokens[list->numTokens++] = write;
+        bool quoted = false;
+        while (*read && (quoted || *read != ' ')) {
+            if (*read == '"') {
+                quoted = !quoted;
+            } else {
+                *write++ = *read;
+            }
+            read++;
+        }
+        if (*read) {
+            read++;
+        }
+        *write = '\0';
+    }
+
+    reserve_tokens(list, list->numTokens + 1);
+    list->tokens[list->numTokens] = NULL;
+    return list->numTokens;
+}
+
+void free_token_list(TokenList* list) {
+    free(list->tokens);
+    init_token_list(list);
+}
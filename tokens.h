@@ -0,0 +1,41 @@
+#ifndef TOKENS_H
+#define TOKENS_H
+
+/* Stores the tokens split from a command line. The array of tokens is reused
+ * for each line, and only grows when a line has more tokens than any before
+ * it. */
+typedef struct {
+    /* Tokens of the last line split, followed by a NULL pointer. Each token
+     * points into the line itself. */
+    char** tokens;
+    /* Number of tokens in the last line split. */
+    int numTokens;
+    /* Number of pointers allocated for tokens. */
+    int capacity;
+} TokenList;
+
+/*
+ * Initialises the given TokenList to be empty. No memory is allocated until a
+ * line is first split.
+ */
+void init_token_list(TokenList* list);
+
+/*
+ * Splits the given line into tokens separated by spaces, storing them in the
+ * given TokenList. Spaces between double quotes do not separate tokens, and
+ * the quotes themselves are removed.
+ *
+ * The line is split in place: each token is null-terminated within the line,
+ * which is modified, and no memory is allocated for the tokens themselves. The
+ * tokens are only valid until the line is changed or freed.
+ *
+ * Returns the number of tokens found.
+ */
+int split_tokens(TokenList* list, char* line);
+
+/*
+ * Frees the memory held by the given TokenList, leaving it empty.
+ */
+void free_token_list(TokenList* list);
+
+#endif
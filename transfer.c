@@ -0,0 +1,194 @@
+#define _GNU_SOURCE
+
+#include "child.h"
+#include "event.h"
+#include "settings.h"
+#include "transfer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// largest number of bytes requested from a single splice() call
+#define TRANSFER_CHUNK (1 << 20)
+
+// number of job IDs the queued input list has room for before it first grows
+#define INITIAL_QUEUED_CAPACITY 16
+
+/* Job IDs of children whose queued input has not yet been written. */
+static int* queuedJobs = NULL;
+static int numQueued = 0;
+static int queuedCapacity = 0;
+
+void queue_input(Child* child, const char* text, size_t length) {
+    if (!child->input.length && !child->inputWatched) {
+        if (numQueued == queuedCapacity) {
+            queuedCapacity = queuedCapacity ? queuedCapacity * 2
+                    : INITIAL_QUEUED_CAPACITY;
+            queuedJobs = realloc(queuedJobs, sizeof(int) * queuedCapacity);
+        }
+        queuedJobs[numQueued++] = child->jobId;
+    }
+    ring_buffer_append(&child->input, text, length);
+
+    if (child->input.length >= (size_t) settings.highWaterMark) {
+        continue_transfer(child);
+    }
+}
+
+bool flush_input(Child* child) {
+    while (child->input.length) {
+        ssize_t numWritten = ring_buffer_write(&child->input, child->pToC);
+        if (numWritten > 0) {
+            child->bytesSent += numWritten;
+        } else if (numWritten < 0 && errno == EINTR) {
+            continue;
+        } else if (numWritten < 0 && errno == EAGAIN) {
+            return false;
+        } else if (numWritten < 0) { // child hung up, so nobody will read it
+            ring_buffer_clear(&child->input);
+        }
+    }
+    return true;
+}
+
+void flush_queued_input() {
+    for (int i = 0; i < numQueued; i++) {
+        Child* child = get_child_by_jobid(queuedJobs[i]);
+        if (child && child->pToC >= 0) {
+            continue_transfer(child);
+        }
+    }
+    numQueued = 0;
+}
+
+void close_input(Child* child) {
+    unwatch_child_input(child);
+    close(child->pToC);
+    child->pToC = -1;
+    child->closeInput = false;
+}
+
+void start_transfer(Child* child, int fd) {
+    child->transferFd = fd;
+    continue_transfer(child);
+}
+
+void continue_transfer(Child* child) {
+    // queued input always goes first, so it stays in the order it was sent
+    if (!flush_input(child)) {
+        watch_child_input(child);
+        return;
+    } else if (child->pipeSource >= 0) {
+        // the target has room, so (re)start watching the source
+        Child* source = get_child_by_jobid(child->pipeSource);
+        unwatch_child_input(child);
+        watch_child(source);
+        relay_pipe(source);
+        return;
+    }
+
+    while (child->transferFd >= 0) {
+        ssize_t numMoved = splice(child->transferFd, NULL, child->pToC, NULL,
+                TRANSFER_CHUNK, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (numMoved > 0) {
+            child->bytesSent += numMoved;
+        } else if (numMoved < 0 && errno == EINTR) {
+            continue;
+        } else if (numMoved < 0 && errno == EAGAIN) {
+            // pipe is full; the event loop resumes when it drains
+            watch_child_input(child);
+            return;
+        } else if (numMoved <= 0) { // end of file or the child hung up
+            cancel_transfer(child);
+        }
+    }
+
+    // a piped job's input is instead closed by relay_pipe() once its source
+    // finishes
+    if (child->closeInput) {
+        close_input(child);
+    } else {
+        unwatch_child_input(child);
+    }
+}
+
+void cancel_transfer(Child* child) {
+    if (child->pipeSource >= 0) {
+        disconnect_pipe(get_child_by_jobid(child->pipeSource));
+    } else if (child->transferFd >= 0) {
+        close(child->transferFd);
+        child->transferFd = -1;
+    }
+}
+
+bool is_transferring(Child* child) {
+    return child->transferFd >= 0 || child->pipeSource >= 0;
+}
+
+void connect_pipe(Child* source, Child* target) {
+    source->pipeTarget = target->jobId;
+    target->pipeSource = source->jobId;
+
+    // the source waits until the target's queued input has been written
+    unwatch_child(source);
+    continue_transfer(target);
+}
+
+/*
+ * Returns true if the given descriptor has room to be written to without
+ * blocking; false otherwise.
+ */
+static bool is_writable(int fd) {
+    struct pollfd pollFd = {.fd = fd, .events = POLLOUT};
+    return poll(&pollFd, 1, 0) > 0 && (pollFd.revents & POLLOUT);
+}
+
+void relay_pipe(Child* source) {
+    Child* target = get_child_by_jobid(source->pipeTarget);
+    while (true) {
+        ssize_t numMoved = splice(source->cToP, NULL, target->pToC, NULL,
+                TRANSFER_CHUNK, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (numMoved > 0) {
+            source->bytesReceived += numMoved;
+            target->bytesSent += numMoved;
+        } else if (numMoved < 0 && errno == EINTR) {
+            continue;
+        } else if (numMoved < 0 && errno == EAGAIN) {
+            // either the source is empty or the target is full; only the
+            // latter needs the source to be paused
+            if (!is_writable(target->pToC)) {
+                unwatch_child(source);
+                watch_child_input(target);
+            }
+            return;
+        } else if (!numMoved) { // source has finished, so finish the target
+            close_child_output(source);
+            disconnect_pipe(source);
+            close_input(target);
+            return;
+        } else { // target's input was closed or the target exited
+            disconnect_pipe(source);
+            return;
+        }
+    }
+}
+
+void disconnect_pipe(Child* source) {
+    Child* target = get_child_by_jobid(source->pipeTarget);
+    source->pipeTarget = -1;
+    target->pipeSource = -1;
+
+    // undo any pause caused by the target being full
+    if (target->pToC >= 0) {
+        unwatch_child_input(target);
+    }
+    if (!source->output.eof) {
+        source->outputPaused = false;
+        watch_child(source);
+        limit_child_output(source);
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef TRANSFER_H
+#define TRANSFER_H
+
+#include "child.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Queues the given text to be written to the given child's input. Queued
+ * input is written with writev(), batching many small messages into few
+ * system calls: it is written immediately once the amount queued for the
+ * child reaches the hwm setting, and otherwise before the event loop next
+ * waits. Input the child's pipe has no room for stays queued until the child
+ * reads, so hq never blocks on a slow child.
+ */
+void queue_input(Child* child, const char* text, size_t length);
+
+/*
+ * Writes as much of the given child's queued input as its pipe has room for.
+ * Queued input is discarded if the child's input has been closed by the
+ * child.
+ *
+ * Returns true if no queued input remains; false otherwise.
+ */
+bool flush_input(Child* child);
+
+/*
+ * Writes the queued input of every child which has had input queued since
+ * this was last called, leaving whatever does not fit to the event loop.
+ */
+void flush_queued_input();
+
+/*
+ * Closes the given child's input pipe, causing it to receive EOF, and stops
+ * watching it.
+ */
+void close_input(Child* child);
+
+/*
+ * Starts transferring the contents of the given open file descriptor into
+ * the given child's standard input. The data is moved with splice(), so it is
+ * never copied through hq's memory. As much as fits in the child's pipe is
+ * moved immediately; the rest is moved by the event loop as the child reads,
+ * so hq never blocks on a slow child.
+ *
+ * Ownership of fd passes to the transfer, which closes it when finished.
+ */
+void start_transfer(Child* child, int fd);
+
+/*
+ * Writes as much of the given child's queued input, followed by its pending
+ * transfer (from a file or a piped job), as the child's pipe has room for,
+ * and watches the pipe if anything remains. A file transfer is finished, and
+ * its descriptor closed, once the file reaches end of file or the child's
+ * input is closed. If the child's input is waiting to be closed, it is closed
+ * once its queued input and any file transfer have been written; a piped job
+ * closes it when its own output ends.
+ */
+void continue_transfer(Child* child);
+
+/*
+ * Abandons the given child's pending transfer, if any, closing its source
+ * file or disconnecting the job piped into it.
+ */
+void cancel_transfer(Child* child);
+
+/*
+ * Returns true if the given child has a transfer in progress, either from a
+ * file or from a job piped into it; false otherwise.
+ */
+bool is_transferring(Child* child);
+
+/*
+ * Connects the output of the given source child to the input of the given
+ * target child. From then on, the source's output is moved into the target's
+ * pipe by splice() as it arrives, without passing through hq's memory. Output
+ * which hq had already read from the source remains available to rcv.
+ *
+ * When the source's output reaches end of file, the target's input is closed.
+ * If the target's input is closed first, the pipe is disconnected and the
+ * source's output is buffered for rcv again.
+ */
+void connect_pipe(Child* source, Child* target);
+
+/*
+ * Moves as much of the given child's output as possible into the child it is
+ * piped into. When the target's pipe is full, the source stops being watched
+ * until the target has room again.
+ */
+void relay_pipe(Child* source);
+
+/*
+ * Disconnects the given child's output from the child it is piped into, and
+ * resumes buffering its output for rcv.
+ */
+void disconnect_pipe(Child* source);
+
+#endif